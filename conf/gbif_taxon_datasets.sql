@@ -0,0 +1,14 @@
+-- Rebuilds the taxon to data set mapping used for the provenance of gfbio_source.
+-- Run it after every GBIF ingest, e.g. psql -f gbif_taxon_datasets.sql gfbio
+-- The new table replaces the old one within a transaction, so queries never see it missing.
+
+BEGIN;
+
+DROP TABLE IF EXISTS gbif.taxon_datasets_new;
+CREATE TABLE gbif.taxon_datasets_new AS SELECT DISTINCT taxon, uid FROM gbif.gbif_lite_time;
+CREATE INDEX ON gbif.taxon_datasets_new (taxon);
+
+DROP TABLE IF EXISTS gbif.taxon_datasets;
+ALTER TABLE gbif.taxon_datasets_new RENAME TO taxon_datasets;
+
+COMMIT;
@@ -204,6 +204,11 @@ std::unique_ptr<PointCollection> ABCDSourceOperator::getPointCollection(const Qu
 
 	auto points = createFeatureCollectionWithAttributes(rect);
 
+	std::vector<std::string> textualQueries;
+	for(auto& attribute : textual_attributes) {
+		textualQueries.push_back(getXPathQuery(attribute));
+	}
+
 	pugi::xml_node units = dataSet.child(prefix("Units").c_str());
 
 	for (pugi::xml_node unit = units.child(prefix("Unit").c_str()); unit; unit = unit.next_sibling(prefix("Unit").c_str())) {
@@ -236,10 +241,9 @@ std::unique_ptr<PointCollection> ABCDSourceOperator::getPointCollection(const Qu
 			points->feature_attributes.numeric(attribute).set(points->getFeatureCount() - 1, value);
 		}
 
-		for(auto& attribute : points->feature_attributes.getTextualKeys()) {
-			std::string query = getXPathQuery(attribute);
-			std::string value = unit.select_node(query.c_str()).node().text().get();
-			points->feature_attributes.textual(attribute).set(points->getFeatureCount() - 1, value);
+		for(size_t a = 0; a < textual_attributes.size(); ++a) {
+			const char *value = unit.select_node(textualQueries[a].c_str()).node().text().get();
+			points->feature_attributes.textual(textual_attributes[a]).set(points->getFeatureCount() - 1, value);
 		}
 
 	}
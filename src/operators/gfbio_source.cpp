@@ -7,6 +7,7 @@
 #include "util/configuration.h"
 #include "util/make_unique.h"
 #include "util/gfbiodatautil.h"
+#include "util/iucnrangecache.h"
 #include "datatypes/simplefeaturecollections/wkbutil.h"
 
 #include <string>
@@ -117,14 +118,8 @@ void GFBioSourceOperator::getProvenance(ProvenanceCollection &pc) {
 
 		std::string taxa = GFBioDataUtil::resolveTaxa(connection, scientificName);
 
-
-		connection.prepare("provenance", "SELECT DISTINCT key, citation, uri from gbif.gbif_lite_time join gbif.datasets ON (uid = key) WHERE taxon = ANY($1)");
-		pqxx::work work(connection);
-		pqxx::result result = work.prepared("provenance")(taxa).exec();
-
-		for(size_t i = 0; i < result.size(); ++i) {
-			auto row = result[i];
-			pc.add(Provenance(row[1].as<std::string>(), "", row[2].as<std::string>(), "data.gfbio_source.gbif"));
+		for(auto &dataSet : GFBioDataUtil::getGBIFProvenance(connection, taxa)) {
+			pc.add(Provenance(dataSet.citation, "", dataSet.uri, "data.gfbio_source.gbif"));
 		}
 	} else {
 		pc.add(Provenance("IUCN 2014. The IUCN Red List of Threatened Species. Version 2014.1. http://www.iucnredlist.org. Downloaded on 06/01/2014.", "http://spatial-data.s3.amazonaws.com/groups/Red%20List%20Terms%20&%20Conditions%20of%20Use.pdf", "http://www.iucnredlist.org/", "data.gfbio_source.iucn"));
@@ -228,16 +223,8 @@ std::unique_ptr<PolygonCollection> GFBioSourceOperator::getPolygonCollection(con
 	//TODO: reuse
 	pqxx::connection connection (Configuration::get<std::string>("operators.gfbiosource.dbcredentials"));
 
-	std::string taxa = GFBioDataUtil::resolveTaxaNames(connection, scientificName);
-
-
-	connection.prepare("occurrences", "SELECT ST_AsEWKT(ST_Collect(geom)) FROM iucn.expert_ranges_all WHERE lower(binomial) = ANY ($1)");
-
-	pqxx::work work(connection);
-	pqxx::result result = work.prepared("occurrences")(taxa).exec();
-    work.commit();
-
-    std::string wkt = result[0][0].as<std::string>();
+	// ranges are served from the local pyramid, the database is only queried on a miss
+	std::string wkt = IUCNRangeCache::getRangesWKT(connection, scientificName, rect);
 
     auto polygons = WKBUtil::readPolygonCollection(wkt, rect);
 
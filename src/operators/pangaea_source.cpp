@@ -8,6 +8,11 @@
 #include "util/timeparser.h"
 #include "util/csvparser.h"
 #include "util/pangaeaapi.h"
+#include "util/pangaeadatastream.h"
+#include "util/threadpool.h"
+#include "util/pangaeatabparser.h"
+#include "util/pangaeachunkparser.h"
+#include "util/pangaeacolumnstore.h"
 
 
 #include <vector>
@@ -16,13 +21,22 @@
 #include <iostream>
 #include <json/json.h>
 #include <regex>
+#include <future>
+#include <functional>
+#include <algorithm>
+#include <cmath>
 
 
 /**
  * Operator that gets points from pangaea
  *
  * Parameters:
- * - dataLink: the link to the tab separated data file
+ * - doi: the DOI of the data set
+ * - dois: alternatively, a list of DOIs. The data sets are fetched concurrently and merged into one
+ *         collection with a textual attribute `dataset_doi`. Requested columns that a data set lacks are
+ *         filled with NaN or empty strings.
+ * - preview: optional object with `rows` and/or `bytes` (default: 1000 rows). Only this prefix of the data
+ *            is transferred and parsed. The numeric global attribute `preview_truncated` tells whether data was left out.
  * - other csv columns
  */
 class PangaeaSourceOperator : public GenericOperator {
@@ -59,7 +73,11 @@ class PangaeaSourceOperator : public GenericOperator {
 
 	private:
 		std::string doi;
-		cURL curl;
+		std::vector<std::string> dois;
+
+		size_t previewRows;
+		size_t previewBytes;
+		bool previewTruncated;
 
 		std::vector<std::string> columns_textual;
 		std::vector<std::string> columns_numeric;
@@ -72,11 +90,12 @@ class PangaeaSourceOperator : public GenericOperator {
 		std::string uri;
 
 		std::unique_ptr<CSVSourceUtil> csvUtil;
+		Json::Value csvParameters;
 
+		std::shared_future<PangaeaAPI::MetaData> metaData;
 
-#ifndef MAPPING_OPERATOR_STUBS
-		void getStringFromServer(std::stringstream& data);
 
+#ifndef MAPPING_OPERATOR_STUBS
 		/**
 		 * check if lat/lon parameters exist
 		 * */
@@ -84,7 +103,40 @@ class PangaeaSourceOperator : public GenericOperator {
 
 		std::string buildCSVHeader(const std::vector<PangaeaAPI::Parameter> parameters);
 
-		std::string extractCSV(std::stringstream &data, PangaeaAPI::MetaData &metaData);
+		/**
+		 * @return the indices of the parameters that are referenced by the column parameters, in file order
+		 */
+		std::vector<size_t> getProjectedColumns(const std::vector<PangaeaAPI::Parameter> &parameters) const;
+
+		/**
+		 * check if the spatial coverage of the data set intersects the query rectangle.
+		 * This is true whenever the orientation of the geometries is unknown.
+		 */
+		bool intersectsQuery(const PangaeaAPI::MetaData &metaData, const QueryRectangle &rect);
+
+		std::unique_ptr<PointCollection> createEmptyPoints(const PangaeaAPI::MetaData &metaData, const QueryRectangle &rect);
+
+		/**
+		 * start fetching the metadata in the background, if not already started
+		 * @return the shared result of the metadata request
+		 */
+		std::shared_future<PangaeaAPI::MetaData> fetchMetaData();
+
+		/**
+		 * parse the points on the parser pool, see PangaeaChunkParser
+		 */
+		std::unique_ptr<PointCollection> parsePointsParallel(std::istream &data, const PangaeaAPI::MetaData &metaData, const QueryRectangle &rect);
+
+		/**
+		 * fetch the points of all data sets concurrently and merge them
+		 */
+		std::unique_ptr<PointCollection> getMultipleDataSetPoints(const QueryRectangle &rect, const QueryTools &tools);
+
+		/**
+		 * append all features of a data set to the merged collection. Attributes of the target that
+		 * are missing in the source are filled with NaN or empty strings.
+		 */
+		static void appendDataSetPoints(PointCollection &target, PointCollection &source, const std::string &dataSetDOI);
 #endif
 };
 REGISTER_OPERATOR(PangaeaSourceOperator, "pangaea_source");
@@ -94,12 +146,47 @@ PangaeaSourceOperator::PangaeaSourceOperator(int sourcecounts[], GenericOperator
 	assumeSources(0);
 	doi = params.get("doi", "").asString();
 
+	if(params.isMember("dois")) {
+		for(auto &dataSetDOI : params["dois"]) {
+			dois.push_back(dataSetDOI.asString());
+		}
+		if(dois.empty()) {
+			throw ArgumentException("PangaeaSourceOperator: dois must not be empty");
+		}
+		doi = dois[0];
+	} else {
+		dois.push_back(doi);
+	}
+
+	previewRows = 0;
+	previewBytes = 0;
+	previewTruncated = false;
+	if(params.isMember("preview")) {
+		const Json::Value &preview = params["preview"];
+		previewRows = static_cast<size_t>(preview.get("rows", 0).asUInt64());
+		previewBytes = static_cast<size_t>(preview.get("bytes", 0).asUInt64());
+		if(previewRows == 0 && previewBytes == 0) {
+			previewRows = 1000;
+		}
+	}
+
 	csvUtil = make_unique<CSVSourceUtil>(params);
+	csvParameters = params;
 }
 
 void PangaeaSourceOperator::writeSemanticParameters(std::ostringstream& stream) {
 	Json::Value params = csvUtil->getParameters();
 	params["doi"] = doi;
+	if(dois.size() > 1) {
+		params["dois"] = Json::Value(Json::arrayValue);
+		for(auto &dataSetDOI : dois) {
+			params["dois"].append(dataSetDOI);
+		}
+	}
+	if(previewRows > 0 || previewBytes > 0) {
+		params["preview"]["rows"] = static_cast<Json::UInt64>(previewRows);
+		params["preview"]["bytes"] = static_cast<Json::UInt64>(previewBytes);
+	}
 
 	stream << params;
 }
@@ -129,7 +216,12 @@ std::string PangaeaSourceOperator::buildCSVHeader(const std::vector<PangaeaAPI::
 		if(i > 0) {
 			ss << csvUtil->field_separator;
 		}
-		ss << "\"" << parameters[i].name << "\"";
+		// quotes in names are escaped, so the CSV parser reads the names the projection is based on
+		std::string name = parameters[i].name;
+		for(size_t position = name.find('"'); position != std::string::npos; position = name.find('"', position + 2)) {
+			name.insert(position, 1, '"');
+		}
+		ss << "\"" << name << "\"";
 	}
 
 	ss << "\n";
@@ -137,72 +229,463 @@ std::string PangaeaSourceOperator::buildCSVHeader(const std::vector<PangaeaAPI::
 	return ss.str();
 }
 
-std::string PangaeaSourceOperator::extractCSV(std::stringstream &data, PangaeaAPI::MetaData &metaData) {
-	// skip initial comment
-	std::string str = data.str();
-	size_t offset = str.find("*/\n") + 3;
-	// skip header column
-	// TODO handle \n in column headers
-	offset = str.find("\n", offset) + 1;
+std::vector<size_t> PangaeaSourceOperator::getProjectedColumns(const std::vector<PangaeaAPI::Parameter> &parameters) const {
+	const Json::Value &columns = csvParameters["columns"];
+
+	std::vector<std::string> names;
+	for(auto &key : {"x", "y", "time1", "time2"}) {
+		if(columns.isMember(key)) {
+			names.push_back(columns[key].asString());
+		}
+	}
+	for(auto &key : {"numeric", "textual"}) {
+		for(auto &column : columns.get(key, Json::Value(Json::arrayValue))) {
+			names.push_back(column.asString());
+		}
+	}
+
+	// unknown columns are reported by the CSV parser
+	std::vector<size_t> projection;
+	for(size_t i = 0; i < parameters.size(); ++i) {
+		if(std::find(names.begin(), names.end(), parameters[i].name) != names.end()) {
+			projection.push_back(i);
+		}
+	}
 
-	std::string dataString = buildCSVHeader(metaData.parameters);
-	dataString += data.str().substr(offset);
+	// keep one column, so that lines are not empty, e.g. when all features use default_x
+	if(projection.empty() && !parameters.empty()) {
+		projection.push_back(0);
+	}
 
-	return dataString;
+	return projection;
+}
+
+bool PangaeaSourceOperator::intersectsQuery(const PangaeaAPI::MetaData &metaData, const QueryRectangle &rect) {
+	if(rect.crsId != CrsId::wgs84()) {
+		return true;
+	}
+
+	const Json::Value &columns = csvParameters["columns"];
+
+	if(!hasGeoReference(metaData.parameters)) {
+		// the spatial coverage itself is used as geometry
+		if(csvParameters.get("geometry", "").asString() == "wkt" && !columns.isMember("x")) {
+			return metaData.intersectsSpatialCoverage(rect.x1, rect.y1, rect.x2, rect.y2);
+		}
+		return true;
+	}
+
+	auto findParameter = [&metaData](const std::string &name) {
+		return std::find_if(metaData.parameters.begin(), metaData.parameters.end(), [&name](const PangaeaAPI::Parameter &parameter) {
+			return parameter.name == name;
+		});
+	};
+	auto x = findParameter(columns.get("x", "").asString());
+	auto y = findParameter(columns.get("y", "").asString());
+	if(x == metaData.parameters.end() || y == metaData.parameters.end()) {
+		return true;
+	}
+
+	if(x->isLongitudeColumn() && y->isLatitudeColumn()) {
+		return metaData.intersectsSpatialCoverage(rect.x1, rect.y1, rect.x2, rect.y2);
+	} else if(x->isLatitudeColumn() && y->isLongitudeColumn()) {
+		return metaData.intersectsSpatialCoverage(rect.y1, rect.x1, rect.y2, rect.x2);
+	}
+
+	return true;
+}
+
+std::unique_ptr<PointCollection> PangaeaSourceOperator::createEmptyPoints(const PangaeaAPI::MetaData &metaData, const QueryRectangle &rect) {
+	std::vector<PangaeaAPI::Parameter> projectedParameters;
+	for(size_t column : getProjectedColumns(metaData.parameters)) {
+		projectedParameters.push_back(metaData.parameters[column]);
+	}
+
+	std::istringstream headerStream(buildCSVHeader(projectedParameters));
+	return csvUtil->getPointCollection(headerStream, rect);
+}
+
+std::shared_future<PangaeaAPI::MetaData> PangaeaSourceOperator::fetchMetaData() {
+	if(!metaData.valid()) {
+		std::string doi = this->doi;
+		metaData = std::async(std::launch::async, [doi]() {
+			return PangaeaAPI::getMetaData(doi);
+		}).share();
+	}
+	return metaData;
+}
+
+/**
+ * pool for parsing large data sets, shared by all queries
+ */
+static ThreadPool &getParserPool() {
+	static ThreadPool pool(static_cast<size_t>(std::max(1, Configuration::get<int>("pangaea.parser.threads", 4))));
+	return pool;
 }
 
 std::unique_ptr<PointCollection> PangaeaSourceOperator::getPointCollection(const QueryRectangle &rect, const QueryTools &tools){
-	PangaeaAPI::MetaData metaData = PangaeaAPI::getMetaData(doi);
+	if(dois.size() > 1) {
+		return getMultipleDataSetPoints(rect, tools);
+	}
+
+	// data sets outside of the query are skipped without any download if their metadata is cached
+	auto cachedMetaData = PangaeaAPI::getCachedMetaData(doi);
+	if(cachedMetaData && !intersectsQuery(*cachedMetaData, rect)) {
+		return createEmptyPoints(*cachedMetaData, rect);
+	}
+
+	// data sets that were downloaded before are read from their columnar representation
+	bool preview = previewRows > 0 || previewBytes > 0;
+	auto dataCache = PangaeaDataStream::getDataCache();
+	std::unique_ptr<PangaeaColumnStore> columnStore;
+	if(dataCache && !preview) {
+		PangaeaDataStream::revalidate(*dataCache, doi);
+		columnStore = PangaeaColumnStore::open(*dataCache, doi);
+		auto points = columnStore ? columnStore->getPoints(csvParameters, rect) : nullptr;
+		if(points) {
+			return points;
+		}
+	}
 
-	std::stringstream data;
-	getStringFromServer(data);
+	// metadata and data are requested concurrently, the data is parsed while it is downloaded
+	auto metaDataFuture = fetchMetaData();
+	const PangaeaAPI::MetaData *metaData;
+	std::unique_ptr<PointCollection> points;
+	{
+		PangaeaDataStream data(doi, [this, &metaDataFuture]() {
+			return buildCSVHeader(metaDataFuture.get().parameters);
+		}, previewRows, previewBytes);
+
+		metaData = &metaDataFuture.get();
+		if(!intersectsQuery(*metaData, rect)) {
+			// aborts the running download
+			return createEmptyPoints(*metaData, rect);
+		}
 
-	std::string dataString = extractCSV(data, metaData);
+		if(!hasGeoReference(metaData->parameters)) {
+			csvUtil->default_x = metaData->spatialCoverageWKT;
+		}
 
-	if(!hasGeoReference(metaData.parameters)) {
-		csvUtil->default_x = metaData.spatialCoverageWKT;
+		try {
+			points = parsePointsParallel(data, *metaData, rect);
+		} catch (...) {
+			// a failed download is the more relevant error
+			data.rethrowIfFailed();
+			throw;
+		}
+		data.rethrowIfFailed();
+		previewTruncated = data.isTruncated();
 	}
 
-	std::istringstream iss(dataString);
-	auto points = csvUtil->getPointCollection(iss, rect);
+	if(preview) {
+		points->global_attributes.setNumeric("preview_truncated", previewTruncated ? 1 : 0);
+		return points;
+	}
+
+	// the data file is cached once the stream is closed, convert it in the background for later queries
+	if(dataCache && !columnStore) {
+		PangaeaColumnStore::buildInBackground(std::move(dataCache), doi, metaData->parameters);
+	}
 
 	return points;
 }
 
 std::unique_ptr<PolygonCollection> PangaeaSourceOperator::getPolygonCollection(const QueryRectangle &rect, const QueryTools &tools){
-	PangaeaAPI::MetaData metaData = PangaeaAPI::getMetaData(doi);
+	if(dois.size() > 1) {
+		throw OperatorException("PangaeaSourceOperator: multiple DOIs are only supported for points");
+	}
 
-	std::stringstream data;
-	getStringFromServer(data);
+	auto cachedMetaData = PangaeaAPI::getCachedMetaData(doi);
+	if(cachedMetaData && !intersectsQuery(*cachedMetaData, rect)) {
+		std::istringstream headerStream(buildCSVHeader(cachedMetaData->parameters));
+		return csvUtil->getPolygonCollection(headerStream, rect);
+	}
 
-	std::string dataString = extractCSV(data, metaData);
+	auto metaDataFuture = fetchMetaData();
+	PangaeaDataStream data(doi, [this, &metaDataFuture]() {
+		return buildCSVHeader(metaDataFuture.get().parameters);
+	});
+
+	const PangaeaAPI::MetaData &metaData = metaDataFuture.get();
+	if(!intersectsQuery(metaData, rect)) {
+		std::istringstream headerStream(buildCSVHeader(metaData.parameters));
+		return csvUtil->getPolygonCollection(headerStream, rect);
+	}
 
 	if(!hasGeoReference(metaData.parameters)) {
 		csvUtil->default_x = metaData.spatialCoverageWKT;
-		fprintf(stderr, ">> %s", metaData.spatialCoverageWKT.c_str());
 	}
 
-	std::istringstream iss(dataString);
-	auto polygons = csvUtil->getPolygonCollection(iss, rect);
+	std::unique_ptr<PolygonCollection> polygons;
+	try {
+		polygons = csvUtil->getPolygonCollection(data, rect);
+	} catch (...) {
+		data.rethrowIfFailed();
+		throw;
+	}
+	data.rethrowIfFailed();
 
 	return polygons;
 }
 
-void PangaeaSourceOperator::getStringFromServer(std::stringstream& data) {
-	curl.setOpt(CURLOPT_PROXY, Configuration::get<std::string>("proxy", "").c_str());
-	curl.setOpt(CURLOPT_URL, concat("https://doi.pangaea.de/", doi, "?format=textfile").c_str());
-	curl.setOpt(CURLOPT_WRITEFUNCTION, cURL::defaultWriteFunction);
-	curl.setOpt(CURLOPT_WRITEDATA, &data);
+std::unique_ptr<PointCollection> PangaeaSourceOperator::parsePointsParallel(std::istream &data, const PangaeaAPI::MetaData &metaData, const QueryRectangle &rect) {
+	size_t chunkSize = static_cast<size_t>(Configuration::get<int>("pangaea.parser.chunksize", 16)) * 1024 * 1024;
+	size_t threshold = static_cast<size_t>(Configuration::get<int>("pangaea.parser.threshold", 1)) * 1024 * 1024;
+
+	// the header of the stream lists all columns, only the requested ones are parsed
+	std::string fullHeader;
+	std::getline(data, fullHeader);
+
+	// the common case of x/y points is handled by the fast parser, otherwise
+	// every chunk is projected to the requested columns and parsed by the generic CSV parser
+	std::shared_ptr<PangaeaTabParser> tabParser;
+	if(PangaeaTabParser::isApplicable(csvParameters)) {
+		std::vector<std::string> columnNames;
+		for(auto &parameter : metaData.parameters) {
+			columnNames.push_back(parameter.name);
+		}
+		tabParser = std::make_shared<PangaeaTabParser>(columnNames, csvParameters);
+	}
+
+	std::vector<size_t> projection = getProjectedColumns(metaData.parameters);
+	std::vector<PangaeaAPI::Parameter> projectedParameters;
+	for(size_t column : projection) {
+		projectedParameters.push_back(metaData.parameters[column]);
+	}
+
+	PangaeaChunkParser parser(tabParser, csvParameters, csvUtil->default_x, projection, buildCSVHeader(projectedParameters));
+	std::unique_ptr<PointCollection> points = parser.parse(data, rect, getParserPool(), chunkSize, threshold);
+
+	if(!points && tabParser) {
+		points = tabParser->createCollection(rect);
+	} else if(!points) {
+		// no data: create an empty collection with all attributes
+		points = createEmptyPoints(metaData, rect);
+	}
+
+	return points;
+}
+
+/**
+ * pool for fetching the data sets of multi DOI queries, shared by all queries. Its tasks
+ * wait for the parser pool, so the two must not be the same.
+ */
+static ThreadPool &getFetchPool() {
+	static ThreadPool pool(static_cast<size_t>(std::max(1, Configuration::get<int>("pangaea.fetch.threads", 8))));
+	return pool;
+}
+
+/**
+ * remove the numeric and textual columns from the parameters that the data set does not have,
+ * so that its query does not fail
+ * @return the removed columns
+ */
+static std::vector<std::string> removeMissingColumns(Json::Value &params, const std::vector<PangaeaAPI::Parameter> &parameters) {
+	std::vector<std::string> missing;
+	for(auto &key : {"numeric", "textual"}) {
+		Json::Value existing(Json::arrayValue);
+		for(auto &column : params["columns"].get(key, Json::Value(Json::arrayValue))) {
+			bool exists = std::any_of(parameters.begin(), parameters.end(), [&column](const PangaeaAPI::Parameter &parameter) {
+				return parameter.name == column.asString();
+			});
+			if(exists) {
+				existing.append(column);
+			} else {
+				missing.push_back(column.asString());
+			}
+		}
+		params["columns"][key] = existing;
+	}
+	return missing;
+}
+
+/**
+ * add the numeric and textual columns the data set does not have, filled with NaN and empty values
+ */
+static void addMissingColumns(PointCollection &points, const Json::Value &params, const std::vector<std::string> &missing) {
+	const Json::Value &columns = params["columns"];
+	auto isRequested = [&columns](const char *key, const std::string &name) {
+		for(auto &column : columns.get(key, Json::Value(Json::arrayValue))) {
+			if(column.asString() == name) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	for(auto &name : missing) {
+		if(isRequested("numeric", name)) {
+			auto &values = points.feature_attributes.addNumericAttribute(name, Unit::unknown());
+			for(size_t feature = 0; feature < points.getFeatureCount(); ++feature) {
+				values.set(feature, NAN);
+			}
+		} else if(isRequested("textual", name)) {
+			auto &values = points.feature_attributes.addTextualAttribute(name, Unit::unknown());
+			for(size_t feature = 0; feature < points.getFeatureCount(); ++feature) {
+				values.set(feature, "");
+			}
+		}
+	}
+}
+
+std::unique_ptr<PointCollection> PangaeaSourceOperator::getMultipleDataSetPoints(const QueryRectangle &rect, const QueryTools &tools) {
+	ThreadPool &pool = getFetchPool();
+
+	struct DataSetResult {
+		std::unique_ptr<PointCollection> points;
+		std::vector<std::string> missingColumns;
+		bool truncated;
+	};
+
+	// every data set is queried by its own operator, at most pool size at once. The tasks get their
+	// own profilers, as the profiler of the query is not thread safe; their costs are added afterwards.
+	std::vector<std::unique_ptr<QueryProfiler>> profilers;
+	std::vector<std::future<DataSetResult>> results;
+	for(auto &dataSetDOI : dois) {
+		Json::Value params = csvParameters;
+		params.removeMember("dois");
+		params["doi"] = dataSetDOI;
+
+		profilers.push_back(make_unique<QueryProfiler>());
+		QueryProfiler *profiler = profilers.back().get();
+		results.push_back(pool.submit([params, &rect, profiler]() mutable -> DataSetResult {
+			Json::Value requested = params;
+			DataSetResult result;
+			result.missingColumns = removeMissingColumns(params, PangaeaAPI::getMetaData(params["doi"].asString()).parameters);
+
+			int sourcecounts[MAX_INPUT_TYPES] = {0};
+			PangaeaSourceOperator dataSet(sourcecounts, nullptr, params);
+			QueryTools tools(*profiler);
+			result.points = dataSet.getPointCollection(rect, tools);
+			result.truncated = dataSet.previewTruncated;
+
+			addMissingColumns(*result.points, requested, result.missingColumns);
+			return result;
+		}));
+	}
+
+	// wait for all data sets before failing, as the tasks reference the query
+	std::vector<DataSetResult> dataSetResults;
+	std::exception_ptr error;
+	for(auto &result : results) {
+		try {
+			dataSetResults.push_back(result.get());
+		} catch (...) {
+			if(!error) {
+				error = std::current_exception();
+			}
+		}
+	}
+	for(auto &profiler : profilers) {
+		tools.profiler += *profiler;
+	}
+	if(error) {
+		std::rethrow_exception(error);
+	}
+
+	// like for a single data set, a column that does not exist at all is an error
+	for(auto &key : {"numeric", "textual"}) {
+		for(auto &column : csvParameters["columns"].get(key, Json::Value(Json::arrayValue))) {
+			bool exists = std::any_of(dataSetResults.begin(), dataSetResults.end(), [&column](const DataSetResult &result) {
+				return std::find(result.missingColumns.begin(), result.missingColumns.end(), column.asString()) == result.missingColumns.end();
+			});
+			if(!exists) {
+				throw ArgumentException(concat("PangaeaSourceOperator: column ", column.asString(), " does not exist in any of the data sets"));
+			}
+		}
+	}
+
+	std::vector<std::unique_ptr<PointCollection>> dataSetPoints;
+	bool truncated = false;
+	for(auto &result : dataSetResults) {
+		dataSetPoints.push_back(std::move(result.points));
+		truncated = truncated || result.truncated;
+	}
+
+	auto points = make_unique<PointCollection>(rect);
+	const Json::Value &columns = csvParameters["columns"];
+	for(auto &column : columns.get("numeric", Json::Value(Json::arrayValue))) {
+		points->feature_attributes.addNumericAttribute(column.asString(), Unit::unknown());
+	}
+	for(auto &column : columns.get("textual", Json::Value(Json::arrayValue))) {
+		points->feature_attributes.addTextualAttribute(column.asString(), Unit::unknown());
+	}
+	points->feature_attributes.addTextualAttribute("dataset_doi", Unit::unknown());
+
+	bool hasTime = std::any_of(dataSetPoints.begin(), dataSetPoints.end(), [](const std::unique_ptr<PointCollection> &dataSet) {
+		return dataSet->hasTime();
+	});
+
+	for(size_t i = 0; i < dois.size(); ++i) {
+		if(hasTime && !dataSetPoints[i]->hasTime()) {
+			dataSetPoints[i]->addDefaultTimestamps();
+		}
+		appendDataSetPoints(*points, *dataSetPoints[i], dois[i]);
+	}
+
+	if(previewRows > 0 || previewBytes > 0) {
+		points->global_attributes.setNumeric("preview_truncated", truncated ? 1 : 0);
+	}
+
+	return points;
+}
+
+void PangaeaSourceOperator::appendDataSetPoints(PointCollection &target, PointCollection &source, const std::string &dataSetDOI) {
+	auto numericKeys = target.feature_attributes.getNumericKeys();
+	auto textualKeys = target.feature_attributes.getTextualKeys();
+	auto sourceNumericKeys = source.feature_attributes.getNumericKeys();
+	auto sourceTextualKeys = source.feature_attributes.getTextualKeys();
+
+	std::vector<bool> numericExists;
+	for(auto &key : numericKeys) {
+		numericExists.push_back(std::find(sourceNumericKeys.begin(), sourceNumericKeys.end(), key) != sourceNumericKeys.end());
+	}
+	std::vector<bool> textualExists;
+	for(auto &key : textualKeys) {
+		textualExists.push_back(std::find(sourceTextualKeys.begin(), sourceTextualKeys.end(), key) != sourceTextualKeys.end());
+	}
+
+	for(size_t feature = 0; feature < source.getFeatureCount(); ++feature) {
+		for(size_t i = source.start_feature[feature]; i < source.start_feature[feature + 1]; ++i) {
+			target.addCoordinate(source.coordinates[i].x, source.coordinates[i].y);
+		}
+		size_t index = target.finishFeature();
+
+		for(size_t k = 0; k < numericKeys.size(); ++k) {
+			double value = numericExists[k] ? source.feature_attributes.numeric(numericKeys[k]).get(feature) : NAN;
+			target.feature_attributes.numeric(numericKeys[k]).set(index, value);
+		}
+		for(size_t k = 0; k < textualKeys.size(); ++k) {
+			if(textualKeys[k] == "dataset_doi") {
+				target.feature_attributes.textual(textualKeys[k]).set(index, dataSetDOI);
+			} else {
+				target.feature_attributes.textual(textualKeys[k]).set(index, textualExists[k] ? source.feature_attributes.textual(textualKeys[k]).get(feature) : "");
+			}
+		}
 
-	curl.perform();
+		if(source.hasTime()) {
+			target.time.push_back(source.time[feature]);
+		}
+	}
 }
 
 void PangaeaSourceOperator::getProvenance(ProvenanceCollection &pc) {
+	if(dois.size() > 1) {
+		for(auto &dataSetDOI : dois) {
+			auto metaData = PangaeaAPI::getMetaData(dataSetDOI);
+			pc.add(Provenance(PangaeaAPI::getCitation(dataSetDOI), metaData.license, metaData.url, "data." + getType()));
+		}
+		return;
+	}
+
 	Provenance provenance;
 
+	// reuses the metadata of a running or finished query
+	auto metaDataFuture = fetchMetaData();
+
 	provenance.citation = PangaeaAPI::getCitation(doi);
 
-	PangaeaAPI::MetaData metaData = PangaeaAPI::getMetaData(doi);
+	const PangaeaAPI::MetaData &metaData = metaDataFuture.get();
 
 	provenance.license = metaData.license;
 	provenance.uri = metaData.url;
@@ -4,7 +4,9 @@
 #include "datatypes/polygoncollection.h"
 #include "operators/operator.h"
 #include <json/json.h>
+#include <set>
 #include "util/terminology.h"
+#include "util/stringdictionary.h"
 
 /**
  * Operator for resolving attributes using the terminology service from gfbio (search api): https://terminologies.gfbio.org/
@@ -15,6 +17,9 @@
  *  - terminology: name of the terminology used to resolve.
  *  - key: the json field of the result to be saved in the resolved attribute. "label" if not provided.
  *         if requested field is an array, the first element will be returned.
+ *  - mappings: object of json fields and the names of the new attributes they are saved in, e.g.
+ *         {"label": "species_label", "uri": "species_uri"}. Replaces key and resolved_attribute, all
+ *         fields are taken from a single search request per term.
  *  - match_type: "exact", "included", "regex", see TerminologyService search API. "exact" if not provided.
  *  - first_hit: bool, see TerminologyService search API. true if not provided.
  *  - on_not_resolvable: if no label for the term was found, what to insert into resolved attribute.
@@ -35,10 +40,15 @@ protected:
     void writeSemanticParameters(std::ostringstream& stream) override;
 
 private:
+    /**
+     * add the resolved attributes to the collection
+     */
+    void resolveAttributes(SimpleFeatureCollection &collection);
+
     std::string attribute_name;
     std::string terminology;
-    std::string key;
-    std::string resolved_attribute;
+    std::vector<std::string> keys;
+    std::vector<std::string> resolved_attributes;
     std::string match_type;
     bool first_hit;
     HandleNotResolvable on_not_resolvable;
@@ -53,10 +63,25 @@ TerminologyResolver::TerminologyResolver(int *sourcecounts, GenericOperator **so
         throw ArgumentException("TerminologyResolver: Only one terminology should be requested, not multiple concatenated by ','.");
     }
     attribute_name      = params.get("attribute_name", "").asString();
-    key                 = params.get("key", "label").asString();
-    resolved_attribute  = params.get("resolved_attribute", "").asString();
-    if(resolved_attribute == attribute_name){
-        throw OperatorException("Terminology Resolver: name of resolved attribute has to be different from existing attribute.");
+
+    if(params.isMember("mappings")){
+        Json::Value mappings = params["mappings"];
+        if(!mappings.isObject() || mappings.empty() || params.isMember("key") || params.isMember("resolved_attribute"))
+            throw ArgumentException("Terminology Resolver: mappings must be a non-empty object and replaces key and resolved_attribute.");
+
+        for(auto &key : mappings.getMemberNames()){
+            keys.push_back(key);
+            resolved_attributes.push_back(mappings[key].asString());
+        }
+    } else {
+        keys.push_back(params.get("key", "label").asString());
+        resolved_attributes.push_back(params.get("resolved_attribute", "").asString());
+    }
+
+    std::set<std::string> attribute_names {attribute_name};
+    for(auto &resolved_attribute : resolved_attributes){
+        if(!attribute_names.insert(resolved_attribute).second)
+            throw OperatorException("Terminology Resolver: names of resolved attributes have to be different from each other and from the existing attribute.");
     }
 
     std::string not_resolvable = params.get("on_not_resolvable", "").asString();
@@ -78,88 +103,50 @@ TerminologyResolver::~TerminologyResolver() { }
 
 REGISTER_OPERATOR(TerminologyResolver, "terminology_resolver");
 
-std::unique_ptr<PointCollection>
-TerminologyResolver::getPointCollection(const QueryRectangle &rect, const QueryTools &tools) {
-    auto points = getPointCollectionFromSource(0, rect, tools);
-
-    // with AttributeArray being private, with no direct access to the underlying vector the strings have
-    // to be copied into a new vector first.
+void TerminologyResolver::resolveAttributes(SimpleFeatureCollection &collection) {
+    // the attribute is dictionary encoded, so every distinct value is resolved once and the
+    // features refer to it by its code instead of deduplicating all strings.
     // the AttributeArray can not be passed to Terminology, because the class is private.
 
-    auto &old_attribute_array = points->feature_attributes.textual(attribute_name);
-    auto &new_attribute_array = points->feature_attributes.addTextualAttribute(resolved_attribute, old_attribute_array.unit);
+    auto &old_attribute_array = collection.feature_attributes.textual(attribute_name);
+    size_t feature_count = collection.getFeatureCount();
 
-    std::vector<std::string> names_in;
-    size_t feature_count = points->getFeatureCount();
-    names_in.reserve(feature_count);
+    StringDictionary dictionary;
+    std::vector<StringDictionary::Code> codes = dictionary.encodeAll(feature_count, [&](size_t i) -> const std::string & {
+        return old_attribute_array.get(i);
+    });
 
-    for(int i = 0; i < feature_count; i++){
-        names_in.push_back(old_attribute_array.get(i));
-    }
+    auto resolved = Terminology::resolveDistinct(dictionary.getValues(), terminology, keys, match_type, first_hit, on_not_resolvable);
 
-    auto names_out = Terminology::resolveMultiple(names_in, terminology, key, match_type, first_hit, on_not_resolvable);
+    // insert the resolved strings of every key into its new attribute array.
+    for(size_t k = 0; k < keys.size(); k++){
+        auto &new_attribute_array = collection.feature_attributes.addTextualAttribute(resolved_attributes[k], old_attribute_array.unit);
+        new_attribute_array.reserve(feature_count);
 
-    new_attribute_array.reserve(names_out.size());
-
-    // insert the resolved strings into the new attribute array.
-    for(int i = 0; i < names_out.size(); i++){
-        new_attribute_array.set(i, names_out[i]);
+        for(size_t i = 0; i < feature_count; i++){
+            new_attribute_array.set(i, resolved[k][codes[i]]);
+        }
     }
+}
 
+std::unique_ptr<PointCollection>
+TerminologyResolver::getPointCollection(const QueryRectangle &rect, const QueryTools &tools) {
+    auto points = getPointCollectionFromSource(0, rect, tools);
+    resolveAttributes(*points);
     return points;
 }
 
 std::unique_ptr<LineCollection>
 TerminologyResolver::getLineCollection(const QueryRectangle &rect, const QueryTools &tools) {
     auto lines = getLineCollectionFromSource(0, rect, tools);
-
-    auto &old_attribute_array = lines->feature_attributes.textual(attribute_name);
-    auto &new_attribute_array = lines->feature_attributes.addTextualAttribute(resolved_attribute, old_attribute_array.unit);
-
-    std::vector<std::string> names_in;
-    size_t feature_count = lines->getFeatureCount();
-    names_in.reserve(feature_count);
-
-    for(int i = 0; i < feature_count; i++){
-        names_in.push_back(old_attribute_array.get(i));
-    }
-
-    auto names_out = Terminology::resolveMultiple(names_in, terminology, key, match_type, first_hit, on_not_resolvable);
-
-    new_attribute_array.reserve(names_out.size());
-
-    // insert the resolved strings into the new attribute array.
-    for(int i = 0; i < names_out.size(); i++){
-        new_attribute_array.set(i, names_out[i]);
-    }
-
+    resolveAttributes(*lines);
     return lines;
 }
 
 std::unique_ptr<PolygonCollection>
 TerminologyResolver::getPolygonCollection(const QueryRectangle &rect, const QueryTools &tools) {
     auto polygons = getPolygonCollectionFromSource(0, rect, tools);
-
-    auto &old_attribute_array = polygons->feature_attributes.textual(attribute_name);
-    auto &new_attribute_array = polygons->feature_attributes.addTextualAttribute(resolved_attribute, old_attribute_array.unit);
-
-    std::vector<std::string> names_in;
-    size_t feature_count = polygons->getFeatureCount();
-    names_in.reserve(feature_count);
-
-    for(int i = 0; i < feature_count; i++){
-        names_in.push_back(old_attribute_array.get(i));
-    }
-
-    auto names_out = Terminology::resolveMultiple(names_in, terminology, key, match_type, first_hit, on_not_resolvable);
-
-    new_attribute_array.reserve(names_out.size());
-
-    // insert the resolved strings into the new attribute array.
-    for(int i = 0; i < names_out.size(); i++){
-        new_attribute_array.set(i, names_out[i]);
-    }
-
+    resolveAttributes(*polygons);
     return polygons;
 }
 
@@ -167,9 +154,14 @@ void TerminologyResolver::writeSemanticParameters(std::ostringstream &stream) {
     Json::Value json(Json::objectValue);
 
     json["attribute_name"]      = attribute_name;
-    json["resolved_attribute"]  = resolved_attribute;
+    if(keys.size() == 1){
+        json["resolved_attribute"]  = resolved_attributes[0];
+        json["key"]                 = keys[0];
+    } else {
+        for(size_t k = 0; k < keys.size(); k++)
+            json["mappings"][keys[k]] = resolved_attributes[k];
+    }
     json["terminology"]         = terminology;
-    json["key"]                 = key;
     json["match_type"]          = match_type;
     json["first_hit"]           = first_hit;
     json["on_not_resolvable"]   = (on_not_resolvable == HandleNotResolvable::EMPTY) ? "EMPTY" : "KEEP";
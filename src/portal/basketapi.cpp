@@ -1,12 +1,17 @@
 #include "basketapi.h"
 
 #include "util/curl.h"
+#include "util/httpclient.h"
+#include "util/jsonextractor.h"
+#include "util/lrucache.h"
 #include "util/gfbiodatautil.h"
 #include "util/configuration.h"
 #include "util/pangaeaapi.h"
+#include "util/threadpool.h"
 
 #include <cstring>
 #include <algorithm>
+#include <chrono>
 #include <future>
 
 BasketAPI::Parameter::Parameter(const Json::Value &json) {
@@ -36,7 +41,7 @@ std::unique_ptr<BasketAPI::BasketEntry> BasketAPI::BasketEntry::fromJson(const J
             throw ArgumentException("Pangaea dataset has no DOI");
         }
 
-		return make_unique<BasketAPI::PangaeaBasketEntry>(doi);
+		return getPangaeaBasketEntry(doi);
 	} else {
 		return make_unique<BasketAPI::ABCDBasketEntry>(json, availableArchives);
 	}
@@ -220,6 +225,27 @@ Json::Value BasketAPI::ABCDBasketEntry::toJson() const {
 	return json;
 }
 
+static ThreadPool &getEntryPool() {
+	static ThreadPool pool(static_cast<size_t>(std::max(1, Configuration::get<int>("gfbio.basket.threads", 8))));
+	return pool;
+}
+
+std::unique_ptr<BasketAPI::PangaeaBasketEntry> BasketAPI::getPangaeaBasketEntry(const std::string &doi) {
+	// resolved entries are kept by DOI
+	static LRUCache<std::string, std::shared_ptr<const PangaeaBasketEntry>> cache(
+			static_cast<size_t>(std::max(0, Configuration::get<int>("gfbio.basket.cache.entries", 10000))),
+			std::chrono::seconds(Configuration::get<int>("gfbio.basket.cache.ttl", 3600)));
+
+	std::shared_ptr<const PangaeaBasketEntry> entry;
+	if(!cache.get(doi, entry)) {
+		// failures are not cached, the data set is resolved again on the next view
+		entry = std::make_shared<const PangaeaBasketEntry>(doi);
+		cache.put(doi, entry);
+	}
+
+	return make_unique<PangaeaBasketEntry>(*entry);
+}
+
 BasketAPI::Basket::Basket(const Json::Value &json, const std::vector<std::string> &availableArchives) {
     if(!json.isMember("lastModifiedDate")) {
         throw ArgumentException("BasketAPI: basket not found");
@@ -229,14 +255,20 @@ BasketAPI::Basket::Basket(const Json::Value &json, const std::vector<std::string
 	timestamp = json.get("lastModifiedDate", "").asString(); //TODO parse and reformat
     userId = json.get("userID", -1).asInt64();
 
+    // entries are resolved on a pool shared by all baskets, so large baskets do not start a thread per entry
+    ThreadPool &pool = getEntryPool();
     std::vector<std::future<std::unique_ptr<BasketEntry>>> futures;
     for(auto &basket : json["basketContent"]["selected"]) {
-        futures.push_back(std::async(std::launch::async, [basket, availableArchives](){
+        futures.push_back(pool.submit([&basket, &availableArchives](){
            return BasketEntry::fromJson(basket, availableArchives);
         })
         );
     }
 
+	// the tasks refer to the json, so all of them must be finished before an error is thrown
+	for(auto &future : futures) {
+		future.wait();
+	}
 	for(auto &future : futures) {
 		entries.push_back(future.get());
 	}
@@ -302,26 +334,20 @@ Json::Value BasketAPI::BasketsOverview::toJson() const {
 
 BasketAPI::BasketsOverview BasketAPI::getBaskets(const std::string &userId, size_t offset, size_t limit) {
 	// get baskets from portal
-	std::stringstream data;
-	cURL curl;
-	curl.setOpt(CURLOPT_PROXY, Configuration::get<std::string>("proxy", "").c_str());
-	curl.setOpt(CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-	curl.setOpt(CURLOPT_USERPWD, concat(Configuration::get<std::string>("gfbio.portal.user"), ":", Configuration::get<std::string>("gfbio.portal.password")).c_str());
-    curl.setOpt(CURLOPT_URL,
-                concat(Configuration::get<std::string>("gfbio.portal.basketsbyuseridwebserviceurl"), "?userId=", userId, "&isMinimal=true&from=", offset + 1,
-                       "&count=", limit).c_str());
-	curl.setOpt(CURLOPT_WRITEFUNCTION, cURL::defaultWriteFunction);
-	curl.setOpt(CURLOPT_WRITEDATA, &data);
+	HttpClient::Request request(concat(Configuration::get<std::string>("gfbio.portal.basketsbyuseridwebserviceurl"), "?userId=", userId,
+									   "&isMinimal=true&from=", offset + 1, "&count=", limit));
+	request.userPassword = concat(Configuration::get<std::string>("gfbio.portal.user"), ":", Configuration::get<std::string>("gfbio.portal.password"));
 
+	std::string data;
 	try {
-		curl.perform();
+		data = HttpClient::perform(request).body;
 	} catch (const cURLException&) {
 		throw BasketAPIException("BasketAPI: could not retrieve baskets from portal");
 	}
 
-    Json::Reader reader(Json::Features::strictMode());
+	static const JsonExtractor extractor({"totalNumberOfBaskets", "results"});
 	Json::Value jsonResponse;
-	if (!reader.parse(data.str(), jsonResponse))
+	if (!extractor.extract(data, jsonResponse) || !jsonResponse.isObject())
 		throw BasketAPIException("BasketAPI: could not parse baskets from portal");
 
 	return BasketsOverview(jsonResponse);
@@ -329,25 +355,21 @@ BasketAPI::BasketsOverview BasketAPI::getBaskets(const std::string &userId, size
 
 BasketAPI::Basket BasketAPI::getBasket(size_t basketId) {
     // get basket from portal
-    std::stringstream data;
-    cURL curl;
-    curl.setOpt(CURLOPT_PROXY, Configuration::get<std::string>("proxy", "").c_str());
-    curl.setOpt(CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-    curl.setOpt(CURLOPT_USERPWD, concat(Configuration::get<std::string>("gfbio.portal.user"), ":", Configuration::get<std::string>("gfbio.portal.password")).c_str());
-    curl.setOpt(CURLOPT_URL,
-                concat(Configuration::get<std::string>("gfbio.portal.basketbyidwebserviceurl"), "?basketId=", basketId, "&isMinimal=false").c_str());
-    curl.setOpt(CURLOPT_WRITEFUNCTION, cURL::defaultWriteFunction);
-    curl.setOpt(CURLOPT_WRITEDATA, &data);
+    HttpClient::Request request(concat(Configuration::get<std::string>("gfbio.portal.basketbyidwebserviceurl"), "?basketId=", basketId, "&isMinimal=false"));
+    request.userPassword = concat(Configuration::get<std::string>("gfbio.portal.user"), ":", Configuration::get<std::string>("gfbio.portal.password"));
 
+    std::string data;
     try {
-        curl.perform();
+        data = HttpClient::perform(request).body;
     } catch (const cURLException&) {
         throw BasketAPIException("BasketAPI: could not retrieve basket from portal");
     }
 
-    Json::Reader reader(Json::Features::strictMode());
+    // the basket also contains the search results as shown in the portal, only the selected entries are needed
+    static const JsonExtractor extractor({"lastModifiedDate", "queryKeyword", "userID", "basketContent.selected",
+                                          "queryJSON.query.function_score.query.filtered.query.simple_query_string.query"});
     Json::Value jsonResponse;
-    if (!reader.parse(data.str(), jsonResponse))
+    if (!extractor.extract(data, jsonResponse) || !jsonResponse.isObject())
         throw BasketAPIException("BasketAPI: could not parse baskets from portal");
 
     return Basket(jsonResponse, GFBioDataUtil::getAvailableABCDArchives());
@@ -121,6 +121,13 @@ public:
 	struct BasketAPIException
 			: public std::runtime_error { using std::runtime_error::runtime_error; };
 
+private:
+	/**
+	 * get the entry of a Pangaea data set, from the cache if it was resolved recently.
+	 * The cache is configured by `gfbio.basket.cache.entries` and `gfbio.basket.cache.ttl`.
+	 */
+	static std::unique_ptr<PangaeaBasketEntry> getPangaeaBasketEntry(const std::string &doi);
+
 };
 
 #endif /* PORTAL_BASKETAPI_H_ */
@@ -5,6 +5,7 @@
 #include "util/concat.h"
 #include "util/exceptions.h"
 #include "util/curl.h"
+#include "util/httpclient.h"
 #include "util/gfbiodatautil.h"
 #include "portal/basketapi.h"
 
@@ -57,29 +58,21 @@ REGISTER_HTTP_SERVICE(GFBioService, "gfbio");
  * @return portaluserId of the user
  */
 size_t GFBioService::authenticateWithPortal(const std::string &token) {
-	std::stringstream data;
-	cURL curl;
-	curl.setOpt(CURLOPT_PROXY, Configuration::get<std::string>("proxy", "").c_str());
-	curl.setOpt(CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-	curl.setOpt(CURLOPT_USERPWD, concat(Configuration::get<std::string>("gfbio.portal.user"), ":", Configuration::get<std::string>("gfbio.portal.password")).c_str());
-	curl.setOpt(CURLOPT_URL, (Configuration::get<std::string>("gfbio.portal.authenticateurl") + "/token/" + token).c_str());
-
-	curl.setOpt(CURLOPT_WRITEFUNCTION, cURL::defaultWriteFunction);
-	curl.setOpt(CURLOPT_POST, 1);
-
-	curl.setOpt(CURLOPT_POSTFIELDS, ("token=" + token).c_str());
-	curl.setOpt(CURLOPT_WRITEDATA, &data);
-
+	HttpClient::Request request(Configuration::get<std::string>("gfbio.portal.authenticateurl") + "/token/" + token);
+	request.userPassword = concat(Configuration::get<std::string>("gfbio.portal.user"), ":", Configuration::get<std::string>("gfbio.portal.password"));
+	request.post = true;
+	request.postFields = "token=" + token;
 
+	std::string data;
 	try {
-		curl.perform();
+		data = HttpClient::perform(request).body;
 	} catch (const cURLException& e) {
 		throw GFBioService::GFBioServiceException("GFBioService: Portal unavailable");
 	}
 
 	Json::Reader reader(Json::Features::strictMode());
 	Json::Value response;
-	if (!reader.parse(data.str(), response))
+	if (!reader.parse(data, response))
 		throw GFBioService::GFBioServiceException("GFBioService: Portal response invalid (malformed JSON)");
 
 
@@ -100,24 +93,19 @@ size_t GFBioService::authenticateWithPortal(const std::string &token) {
  * @return the first element from the portal's JSON response array
  */
 Json::Value GFBioService::getUserDetailsFromPortal(const size_t userId) {
-	std::stringstream data;
-	cURL curl;
-	curl.setOpt(CURLOPT_PROXY, Configuration::get<std::string>("proxy", "").c_str());
-	curl.setOpt(CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-	curl.setOpt(CURLOPT_USERPWD, concat(Configuration::get<std::string>("gfbio.portal.user"), ":", Configuration::get<std::string>("gfbio.portal.password")).c_str());
-	curl.setOpt(CURLOPT_URL, (concat(Configuration::get<std::string>("gfbio.portal.userdetailswebserviceurl"), "?userId=", userId)).c_str());
-	curl.setOpt(CURLOPT_WRITEFUNCTION, cURL::defaultWriteFunction);
-	curl.setOpt(CURLOPT_WRITEDATA, &data);
+	HttpClient::Request request(concat(Configuration::get<std::string>("gfbio.portal.userdetailswebserviceurl"), "?userId=", userId));
+	request.userPassword = concat(Configuration::get<std::string>("gfbio.portal.user"), ":", Configuration::get<std::string>("gfbio.portal.password"));
 
+	std::string data;
 	try {
-		curl.perform();
+		data = HttpClient::perform(request).body;
 	} catch (const cURLException& e) {
 		throw GFBioService::GFBioServiceException("GFBioService: Portal unavailable");
 	}
 
 	Json::Reader reader(Json::Features::strictMode());
 	Json::Value response;
-	if (!reader.parse(data.str(), response) || response.size() < 1 || !response[0].isMember("emailAddress"))
+	if (!reader.parse(data, response) || response.size() < 1 || !response[0].isMember("emailAddress"))
 		throw GFBioService::GFBioServiceException("GFBioService: Portal response invalid (malformed JSON)");
 
 	return response[0];
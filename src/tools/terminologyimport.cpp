@@ -0,0 +1,43 @@
+#include "util/terminologysnapshot.h"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+/**
+ * Imports a terminology dump `<terminology>.jsonl` into the snapshot `<terminology>.snapshot`
+ * next to it, or into the given snapshot file. The new snapshot replaces the old one
+ * atomically and is picked up by running processes on their next query.
+ */
+int main(int argc, char *argv[]) {
+	if(argc < 2 || argc > 3) {
+		std::fprintf(stderr, "Usage: %s <terminology>.jsonl [<snapshot>]\n", argv[0]);
+		return 1;
+	}
+
+	std::string dumpPath = argv[1];
+	std::string snapshotPath;
+	if(argc == 3) {
+		snapshotPath = argv[2];
+	} else {
+		const std::string extension = ".jsonl";
+		if(dumpPath.size() <= extension.size() || dumpPath.compare(dumpPath.size() - extension.size(), extension.size(), extension) != 0) {
+			std::fprintf(stderr, "%s: the dump %s does not end with %s\n", argv[0], dumpPath.c_str(), extension.c_str());
+			return 1;
+		}
+		snapshotPath = dumpPath.substr(0, dumpPath.size() - extension.size()) + ".snapshot";
+	}
+
+	try {
+		TerminologySnapshot::import(dumpPath, snapshotPath);
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		return 1;
+	}
+
+	if(!TerminologySnapshot::open(snapshotPath)) {
+		std::fprintf(stderr, "%s: the snapshot %s is invalid\n", argv[0], snapshotPath.c_str());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include "adaptivelimiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+AdaptiveLimiter::AdaptiveLimiter(size_t maxLimit, double hedgePercentile, size_t breakerFailures, int breakerCooldown)
+		: inFlight(0), maxLimit(std::max<size_t>(maxLimit, 1)), limit(std::min<size_t>(this->maxLimit, 4)), slowStart(true),
+		  hedgePercentile(hedgePercentile), breakerFailures(breakerFailures), breakerCooldown(std::max(0, breakerCooldown)),
+		  nextLatency(0), failures(0) {
+	latencies.reserve(SAMPLES);
+}
+
+bool AdaptiveLimiter::isOpen(Clock::time_point now) const {
+	return breakerFailures > 0 && failures >= breakerFailures && now < openUntil;
+}
+
+bool AdaptiveLimiter::isAvailable() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return !isOpen(Clock::now());
+}
+
+size_t AdaptiveLimiter::computeLimit(Clock::time_point now) const {
+	if(isOpen(now)) {
+		return 0;
+	}
+
+	if(breakerFailures > 0 && failures >= breakerFailures) {
+		// probe the service with a single request
+		return 1;
+	}
+
+	return std::min(maxLimit, std::max<size_t>(1, static_cast<size_t>(limit)));
+}
+
+size_t AdaptiveLimiter::getLimit() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return computeLimit(Clock::now());
+}
+
+bool AdaptiveLimiter::acquire(bool wait) {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		size_t currentLimit = computeLimit(Clock::now());
+		if(currentLimit == 0) {
+			return false;
+		}
+		if(inFlight < currentLimit) {
+			++inFlight;
+			return true;
+		}
+		if(!wait) {
+			return false;
+		}
+		changed.wait(lock);
+	}
+}
+
+void AdaptiveLimiter::release() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(inFlight > 0) {
+			--inFlight;
+		}
+	}
+	changed.notify_one();
+}
+
+long AdaptiveLimiter::getHedgeDelay() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(hedgePercentile <= 0 || latencies.size() < MIN_SAMPLES) {
+		return 0;
+	}
+	return std::max(1L, getPercentile(hedgePercentile));
+}
+
+void AdaptiveLimiter::onFinished(long latency, bool success) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Clock::time_point now = Clock::now();
+
+	if(!success) {
+		++failures;
+		if(breakerFailures > 0 && failures >= breakerFailures) {
+			openUntil = now + breakerCooldown;
+			// waiting requests must fail instead of waiting for the cool down
+			changed.notify_all();
+		}
+		decrease(now, 0.5);
+		return;
+	}
+
+	failures = 0;
+	if(latencies.size() < SAMPLES) {
+		latencies.push_back(latency);
+	} else {
+		latencies[nextLatency] = latency;
+	}
+	nextLatency = (nextLatency + 1) % SAMPLES;
+
+	// requests queue up at the service if they take much longer than the fast ones
+	if(latencies.size() >= MIN_SAMPLES && latency > 2 * getPercentile(10) + 10) {
+		decrease(now, 0.9);
+		return;
+	}
+
+	limit = std::min(static_cast<double>(maxLimit), limit + (slowStart ? 1.0 : 1.0 / limit));
+}
+
+void AdaptiveLimiter::decrease(Clock::time_point now, double factor) {
+	// requests that were sent before the last decrease must not shrink the limit again
+	long window = latencies.size() >= MIN_SAMPLES ? getPercentile(50) : 0;
+	if(!slowStart && now < lastDecrease + std::chrono::milliseconds(window)) {
+		return;
+	}
+
+	slowStart = false;
+	lastDecrease = now;
+	limit = std::max(1.0, limit * factor);
+}
+
+long AdaptiveLimiter::getPercentile(double percentile) const {
+	std::vector<long> sorted(latencies);
+	size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+	rank = std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0);
+	std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+	return sorted[rank];
+}
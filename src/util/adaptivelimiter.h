@@ -0,0 +1,95 @@
+#ifndef UTIL_ADAPTIVELIMITER_H_
+#define UTIL_ADAPTIVELIMITER_H_
+
+#include "util/httpclient.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * Concurrency control for requests to a single service.
+ *
+ * The number of concurrent requests follows an additive increase, multiplicative decrease
+ * scheme: it grows by one per window of fast, successful requests and shrinks when requests
+ * fail or their latency rises well above the fastest recent ones. Requests that take longer
+ * than a percentile of the recent latencies are duplicated.
+ *
+ * After a number of consecutive failures the circuit opens and no requests are allowed for
+ * a cool down period. Afterwards a single request at a time probes the service until one
+ * succeeds.
+ *
+ * The limit applies to all requests that acquired a slot, so a limiter shared by concurrent
+ * queries bounds their requests in total.
+ */
+class AdaptiveLimiter : public HttpClient::Controller {
+public:
+	/**
+	 * @param maxLimit the maximum number of concurrent requests
+	 * @param hedgePercentile the latency percentile after which a request is duplicated, 0 to disable duplicates
+	 * @param breakerFailures the number of consecutive failures that opens the circuit, 0 to never open it
+	 * @param breakerCooldown the seconds the circuit stays open
+	 */
+	AdaptiveLimiter(size_t maxLimit, double hedgePercentile, size_t breakerFailures, int breakerCooldown);
+
+	AdaptiveLimiter(const AdaptiveLimiter&) = delete;
+	AdaptiveLimiter &operator=(const AdaptiveLimiter&) = delete;
+
+	/**
+	 * @return false if the circuit is open and requests must not be sent
+	 */
+	bool isAvailable();
+
+	/**
+	 * @return the current maximum number of concurrent requests, 0 if the circuit is open
+	 */
+	size_t getLimit();
+
+	bool acquire(bool wait) override;
+	void release() override;
+	long getHedgeDelay() override;
+	void onFinished(long latency, bool success) override;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	bool isOpen(Clock::time_point now) const;
+	size_t computeLimit(Clock::time_point now) const;
+	void decrease(Clock::time_point now, double factor);
+	long getPercentile(double percentile) const;
+
+	static const size_t SAMPLES = 256;
+	static const size_t MIN_SAMPLES = 32;
+
+	std::mutex mutex;
+
+	/**
+	 * notified when a slot is released or the circuit opens
+	 */
+	std::condition_variable changed;
+	size_t inFlight;
+	size_t maxLimit;
+	double limit;
+
+	/**
+	 * true until the first decrease, the limit grows by one per successful request meanwhile
+	 */
+	bool slowStart;
+	double hedgePercentile;
+	size_t breakerFailures;
+	std::chrono::seconds breakerCooldown;
+
+	/**
+	 * ring buffer of the latencies of recent successful requests in milliseconds
+	 */
+	std::vector<long> latencies;
+	size_t nextLatency;
+
+	size_t failures;
+	Clock::time_point openUntil;
+	Clock::time_point lastDecrease;
+};
+
+#endif /* UTIL_ADAPTIVELIMITER_H_ */
@@ -0,0 +1,110 @@
+#include "curlstreambuffer.h"
+
+CurlStreamBuffer::CurlStreamBuffer(const std::string &url, std::unique_ptr<FileCache::Writer> cacheWriter,
+								   std::function<void(bool, const HttpClient::Response&)> onFinished)
+		: cacheWriter(std::move(cacheWriter)), onFinished(onFinished), queuedBytes(0), finished(false), aborted(false) {
+	setg(nullptr, nullptr, nullptr);
+	thread = std::thread(&CurlStreamBuffer::download, this, url);
+}
+
+CurlStreamBuffer::~CurlStreamBuffer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		aborted = true;
+	}
+	condition.notify_all();
+	thread.join();
+}
+
+void CurlStreamBuffer::download(const std::string &url) {
+	bool success = false;
+	HttpClient::Response response;
+	try {
+		HttpClient::Request request(url);
+		request.failOnError = true;
+
+		response = HttpClient::perform(request, CurlStreamBuffer::writeFunction, this);
+
+		if(cacheWriter) {
+			cacheWriter->commit();
+		}
+		success = true;
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!aborted) {
+			error = std::current_exception();
+		}
+	}
+
+	if(onFinished) {
+		onFinished(success, response);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished = true;
+	}
+	condition.notify_all();
+}
+
+size_t CurlStreamBuffer::writeFunction(void *buffer, size_t size, size_t nmemb, void *userp) {
+	auto &streamBuffer = *reinterpret_cast<CurlStreamBuffer*>(userp);
+	size_t bytes = size * nmemb;
+	if(bytes == 0) {
+		return 0;
+	}
+
+	if(streamBuffer.cacheWriter) {
+		streamBuffer.cacheWriter->write(reinterpret_cast<const char*>(buffer), bytes);
+	}
+
+	std::unique_lock<std::mutex> lock(streamBuffer.mutex);
+	streamBuffer.condition.wait(lock, [&streamBuffer] {
+		return streamBuffer.aborted || streamBuffer.queuedBytes < maxQueuedBytes;
+	});
+
+	if(streamBuffer.aborted) {
+		// returning a different size makes curl abort the transfer
+		return 0;
+	}
+
+	streamBuffer.chunks.emplace_back(reinterpret_cast<const char*>(buffer), bytes);
+	streamBuffer.queuedBytes += bytes;
+	lock.unlock();
+	streamBuffer.condition.notify_all();
+
+	return bytes;
+}
+
+CurlStreamBuffer::int_type CurlStreamBuffer::underflow() {
+	if(gptr() < egptr()) {
+		return traits_type::to_int_type(*gptr());
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	condition.wait(lock, [this] {
+		return !chunks.empty() || finished;
+	});
+
+	if(chunks.empty()) {
+		return traits_type::eof();
+	}
+
+	current = std::move(chunks.front());
+	chunks.pop_front();
+	queuedBytes -= current.size();
+	lock.unlock();
+	condition.notify_all();
+
+	char *begin = &current[0];
+	setg(begin, begin, begin + current.size());
+
+	return traits_type::to_int_type(*gptr());
+}
+
+void CurlStreamBuffer::rethrowIfFailed() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(error) {
+		std::rethrow_exception(error);
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef UTIL_CURLSTREAMBUFFER_H_
+#define UTIL_CURLSTREAMBUFFER_H_
+
+#include "util/filecache.h"
+#include "util/httpclient.h"
+
+#include <streambuf>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <exception>
+#include <memory>
+#include <functional>
+
+/**
+ * Stream buffer that is filled by a download running in a background thread.
+ *
+ * The download hands over the chunks it receives through a bounded queue, so
+ * only a constant number of bytes is held in memory, independent of the size
+ * of the downloaded file. Optionally, the received data is written to a cache
+ * entry, which is committed once the download completed successfully.
+ *
+ * Destroying the buffer before the download finished aborts the transfer.
+ */
+class CurlStreamBuffer : public std::streambuf {
+public:
+	/**
+	 * @param url the url to download
+	 * @param cacheWriter optional cache entry the data is written to
+	 * @param onFinished optional callback that is called from the download thread when the transfer
+	 *        ended, with true if it completed successfully and the cache entry was committed, and
+	 *        the response without its body
+	 */
+	CurlStreamBuffer(const std::string &url, std::unique_ptr<FileCache::Writer> cacheWriter = nullptr,
+					 std::function<void(bool, const HttpClient::Response&)> onFinished = nullptr);
+	virtual ~CurlStreamBuffer();
+
+	/**
+	 * throws the error of the download, if it failed. Reading from the buffer
+	 * only indicates the end of the data in this case.
+	 */
+	void rethrowIfFailed();
+
+protected:
+	virtual int_type underflow();
+
+private:
+	static size_t writeFunction(void *buffer, size_t size, size_t nmemb, void *userp);
+
+	void download(const std::string &url);
+
+	static const size_t maxQueuedBytes = 4 * 1024 * 1024;
+
+	std::unique_ptr<FileCache::Writer> cacheWriter;
+	std::function<void(bool, const HttpClient::Response&)> onFinished;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::string> chunks;
+	size_t queuedBytes;
+	bool finished;
+	bool aborted;
+	std::exception_ptr error;
+
+	// chunk currently exposed as get area
+	std::string current;
+
+	std::thread thread;
+};
+
+#endif /* UTIL_CURLSTREAMBUFFER_H_ */
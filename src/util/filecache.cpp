@@ -0,0 +1,180 @@
+#include "filecache.h"
+
+#include "util/concat.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+
+FileCache::FileCache(const std::string &directory, size_t maxSize, size_t evictionInterval)
+		: directory(directory), maxSize(maxSize), evictionInterval(evictionInterval > 0 ? evictionInterval : 1), writes(0) {
+	createDirectories(directory);
+}
+
+std::string FileCache::sanitize(const std::string &key) {
+	std::stringstream ss;
+	for(char c : key) {
+		if (std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-')
+			ss << c;
+		else
+			ss << '_';
+	}
+	return ss.str();
+}
+
+void FileCache::createDirectories(const std::string &directory) {
+	for(size_t pos = directory.find('/', 1); ; pos = directory.find('/', pos + 1)) {
+		std::string parent = directory.substr(0, pos);
+		if(!parent.empty() && mkdir(parent.c_str(), 0755) != 0 && errno != EEXIST) {
+			throw std::runtime_error(concat("FileCache: could not create directory ", parent));
+		}
+
+		if(pos == std::string::npos) {
+			break;
+		}
+	}
+}
+
+std::string FileCache::getPath(const std::string &key) const {
+	return concat(directory, "/", sanitize(key));
+}
+
+bool FileCache::open(const std::string &key, std::ifstream &file) const {
+	file.open(getPath(key), std::ios::binary);
+	if(!file.is_open()) {
+		return false;
+	}
+
+	if(maxSize > 0) {
+		// mark entry as recently used
+		utime(getPath(key).c_str(), nullptr);
+	}
+
+	return true;
+}
+
+bool FileCache::get(const std::string &key, std::string &value) const {
+	std::ifstream file;
+	if(!open(key, file)) {
+		return false;
+	}
+
+	std::stringstream ss;
+	ss << file.rdbuf();
+	value = ss.str();
+
+	return true;
+}
+
+void FileCache::put(const std::string &key, const std::string &value) const {
+	Writer writer(*this, key);
+	writer.write(value.data(), value.size());
+	writer.commit();
+}
+
+void FileCache::remove(const std::string &key) const {
+	std::remove(getPath(key).c_str());
+}
+
+std::unique_ptr<FileCache::Writer> FileCache::createWriter(const std::string &key) const {
+	return std::unique_ptr<Writer>(new Writer(*this, key));
+}
+
+FileCache::Writer::Writer(const FileCache &cache, const std::string &key)
+		: cache(cache), path(cache.getPath(key)), committed(false) {
+	// unique name per process and thread, so concurrent writers do not interfere
+	temporaryPath = concat(path, ".tmp.", getpid(), ".", std::this_thread::get_id());
+	file.open(temporaryPath, std::ios::binary | std::ios::trunc);
+}
+
+FileCache::Writer::~Writer() {
+	if(!committed) {
+		file.close();
+		std::remove(temporaryPath.c_str());
+	}
+}
+
+void FileCache::Writer::write(const char *data, size_t size) {
+	file.write(data, size);
+}
+
+void FileCache::Writer::commit() {
+	file.close();
+	if(file.fail()) {
+		std::remove(temporaryPath.c_str());
+		throw std::runtime_error(concat("FileCache: could not write ", temporaryPath));
+	}
+
+	if(std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+		throw std::runtime_error(concat("FileCache: could not write ", path));
+	}
+	committed = true;
+
+	if(cache.maxSize > 0 && ++cache.writes % cache.evictionInterval == 0) {
+		cache.evict();
+	}
+}
+
+void FileCache::evict() const {
+	struct Entry {
+		std::string path;
+		time_t lastUsed;
+		size_t size;
+	};
+
+	DIR *dir = opendir(directory.c_str());
+	if(dir == nullptr) {
+		return;
+	}
+
+	std::vector<Entry> entries;
+	size_t totalSize = 0;
+	while(struct dirent *file = readdir(dir)) {
+		std::string path = concat(directory, "/", file->d_name);
+		if(path.find(".tmp.") != std::string::npos) {
+			// entry that is currently being written
+			continue;
+		}
+
+		struct stat info;
+		if(stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+			continue;
+		}
+
+		// small entries occupy whole blocks, so the allocated space is accounted instead of the file size
+		size_t size = static_cast<size_t>(info.st_blocks) * 512;
+		totalSize += size;
+		entries.push_back(Entry {path, info.st_mtime, size});
+	}
+	closedir(dir);
+
+	if(totalSize <= maxSize) {
+		return;
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+		return a.lastUsed < b.lastUsed;
+	});
+
+	// other workers may evict concurrently, so files might already be gone.
+	// Readers that already opened an evicted file can still finish reading it.
+	for(auto &entry : entries) {
+		if(totalSize <= maxSize) {
+			break;
+		}
+		std::remove(entry.path.c_str());
+		totalSize -= entry.size;
+	}
+}
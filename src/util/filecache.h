@@ -0,0 +1,97 @@
+#ifndef UTIL_FILECACHE_H_
+#define UTIL_FILECACHE_H_
+
+#include <string>
+#include <fstream>
+#include <memory>
+#include <atomic>
+
+/**
+ * Simple key/value store backed by a directory on the local disk.
+ *
+ * Every entry is written to a temporary file first and then renamed into place,
+ * so concurrent readers (threads as well as other worker processes) never see a
+ * partially written entry.
+ *
+ * If a maximum size is given, the least recently used entries are evicted after
+ * writing until the disk space allocated for the entries is below that limit. Reading an
+ * entry updates its modification time, which serves as LRU timestamp. Caches with many
+ * small entries can evict only after every n-th write of the instance, as eviction
+ * scans the whole directory.
+ */
+class FileCache {
+public:
+	explicit FileCache(const std::string &directory, size_t maxSize = 0, size_t evictionInterval = 1);
+
+	/**
+	 * read the entry for the given key
+	 * @return false if there is no entry for the key
+	 */
+	bool get(const std::string &key, std::string &value) const;
+
+	/**
+	 * open the entry for the given key for reading
+	 * @return false if there is no entry for the key
+	 */
+	bool open(const std::string &key, std::ifstream &file) const;
+
+	/**
+	 * atomically store the value for the given key, replacing an existing entry
+	 */
+	void put(const std::string &key, const std::string &value) const;
+
+	/**
+	 * remove the entry for the given key, if it exists. Readers that opened it before keep their data.
+	 */
+	void remove(const std::string &key) const;
+
+	/**
+	 * Writes a large entry incrementally. The entry only becomes visible on commit,
+	 * an uncommitted entry is discarded when the writer is destroyed.
+	 */
+	class Writer {
+	public:
+		Writer(const FileCache &cache, const std::string &key);
+		~Writer();
+
+		void write(const char *data, size_t size);
+		void commit();
+
+	private:
+		const FileCache &cache;
+		std::string path;
+		std::string temporaryPath;
+		std::ofstream file;
+		bool committed;
+	};
+
+	std::unique_ptr<Writer> createWriter(const std::string &key) const;
+
+	/**
+	 * @return the file path of the entry for the given key
+	 */
+	std::string getPath(const std::string &key) const;
+
+	/**
+	 * map a key to a valid file name
+	 */
+	static std::string sanitize(const std::string &key);
+
+	/**
+	 * create the given directory and all of its parents
+	 */
+	static void createDirectories(const std::string &directory);
+
+private:
+	std::string directory;
+	size_t maxSize;
+	size_t evictionInterval;
+	mutable std::atomic<size_t> writes;
+
+	/**
+	 * remove least recently used entries until the cache size is below maxSize
+	 */
+	void evict() const;
+};
+
+#endif /* UTIL_FILECACHE_H_ */
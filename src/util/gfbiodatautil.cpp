@@ -4,40 +4,100 @@
 #include "util/enumconverter.h"
 #include "gfbiodatautil.h"
 #include "util/configuration.h"
+#include "util/concat.h"
+#include "util/sharedcache.h"
+#include "util/lrucache.h"
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 
 
 std::string GFBioDataUtil::resolveTaxa(pqxx::connection &connection, std::string &scientificName) {
-	connection.prepare("taxa", "SELECT DISTINCT taxon FROM gbif.gbif_taxon_to_name WHERE name ILIKE $1");
+	return queryTaxa(connection, "SELECT DISTINCT taxon FROM gbif.gbif_taxon_to_name WHERE name ILIKE $1", "taxa", scientificName);
+}
+
+std::string GFBioDataUtil::resolveTaxaNames(pqxx::connection &connection, std::string &scientificName) {
+	return queryTaxa(connection, "SELECT DISTINCT lower(name) FROM gbif.gbif_taxon_to_name WHERE name ILIKE $1", "names", scientificName);
+}
+
+std::string GFBioDataUtil::queryTaxa(pqxx::connection &connection, const std::string &query, const std::string &kind, const std::string &scientificName) {
+	// the taxa of a name are shared by all workers of the node
+	std::shared_ptr<SharedCache> cache = SharedCache::get("taxa");
+	std::string cacheKey = concat(kind, ":", scientificName);
+	std::string taxa;
+	if(cache && cache->get(cacheKey, taxa)) {
+		return taxa;
+	}
+
+	connection.prepare("taxa", query);
 	pqxx::work work(connection);
 	pqxx::result result = work.prepared("taxa")(scientificName + "%").exec();
 
-	std::stringstream taxa;
-	taxa << "{";
+	std::stringstream stream;
+	stream << "{";
 	for(size_t i = 0; i < result.size(); ++i) {
 		if(i != 0)
-			taxa << ",";
-		taxa << result[i][0];
+			stream << ",";
+		stream << result[i][0];
+	}
+	stream << "}";
+	taxa = stream.str();
+
+	if(cache) {
+		cache->put(cacheKey, taxa, Configuration::get<int>("gfbio.taxa.ttl", 86400));
 	}
-	taxa << "}";
-	return taxa.str();
+	return taxa;
 }
 
-std::string GFBioDataUtil::resolveTaxaNames(pqxx::connection &connection, std::string &scientificName) {
-	connection.prepare("taxa", "SELECT DISTINCT lower(name) FROM gbif.gbif_taxon_to_name WHERE name ILIKE $1");
+std::vector<GFBioDataUtil::DataSetProvenance> GFBioDataUtil::getGBIFProvenance(pqxx::connection &connection, const std::string &taxa) {
+	// the provenance is kept in memory of the process, in front of the shared cache which is disabled by default
+	static LRUCache<std::string, std::vector<DataSetProvenance>> localCache(
+			static_cast<size_t>(std::max(0, Configuration::get<int>("gfbio.provenance.entries", 1000))),
+			std::chrono::seconds(Configuration::get<int>("gfbio.provenance.ttl", 86400)));
+
+	std::vector<DataSetProvenance> provenance;
+	if(localCache.get(taxa, provenance)) {
+		return provenance;
+	}
+
+	// the provenance of a taxa set is shared by all workers of the node, as an array of [citation, uri] pairs
+	std::shared_ptr<SharedCache> cache = SharedCache::get("provenance");
+	std::string content;
+	Json::Value json;
+	Json::Reader reader(Json::Features::strictMode());
+	if(cache && cache->get(taxa, content) && reader.parse(content, json) && json.isArray()) {
+		for(auto &dataSet : json) {
+			provenance.push_back(DataSetProvenance {dataSet[0].asString(), dataSet[1].asString()});
+		}
+		localCache.put(taxa, provenance);
+		return provenance;
+	}
+
+	// gbif.taxon_datasets is a precomputed taxon -> data set mapping, see conf/gbif_taxon_datasets.sql
+	connection.prepare("provenance", "SELECT DISTINCT citation, uri FROM gbif.taxon_datasets JOIN gbif.datasets ON (uid = key) WHERE taxon = ANY($1)");
 	pqxx::work work(connection);
-	pqxx::result result = work.prepared("taxa")(scientificName + "%").exec();
+	pqxx::result result = work.prepared("provenance")(taxa).exec();
+	work.commit();
 
-	std::stringstream taxa;
-	taxa << "{";
+	json = Json::Value(Json::arrayValue);
 	for(size_t i = 0; i < result.size(); ++i) {
-		if(i != 0)
-			taxa << ",";
-		taxa << result[i][0];
+		auto row = result[i];
+		provenance.push_back(DataSetProvenance {row[0].as<std::string>(), row[1].as<std::string>()});
+
+		Json::Value dataSet(Json::arrayValue);
+		dataSet.append(provenance.back().citation);
+		dataSet.append(provenance.back().uri);
+		json.append(dataSet);
 	}
-	taxa << "}";
-	return taxa.str();
+
+	if(cache) {
+		Json::FastWriter writer;
+		cache->put(taxa, writer.write(json), Configuration::get<int>("gfbio.provenance.ttl", 86400));
+	}
+	localCache.put(taxa, provenance);
+
+	return provenance;
 }
 
 size_t GFBioDataUtil::countGBIFResults(std::string &scientificName) {
@@ -10,9 +10,24 @@
 class GFBioDataUtil {
 public:
 
+	struct DataSetProvenance {
+		std::string citation;
+		std::string uri;
+	};
+
+	/**
+	 * resolve the name to the set of matching GBIF taxa. Results are cached for all workers of the node.
+	 */
 	static std::string resolveTaxa(pqxx::connection &connection, std::string &scientificName);
 	static std::string resolveTaxaNames(pqxx::connection &connection, std::string &scientificName);
 
+	/**
+	 * get the GBIF data sets that contain occurrences of the given taxa.
+	 * Results are cached for all workers of the node for `gfbio.provenance.ttl` seconds.
+	 * @param taxa the taxa set as returned by resolveTaxa
+	 */
+	static std::vector<DataSetProvenance> getGBIFProvenance(pqxx::connection &connection, const std::string &taxa);
+
 	static size_t countGBIFResults(std::string &scientificName);
 
 	static size_t countIUCNResults(std::string &scientificName);
@@ -21,6 +36,8 @@ public:
 
 	static Json::Value getGFBioDataCentersJSON();
 
+private:
+	static std::string queryTaxa(pqxx::connection &connection, const std::string &query, const std::string &kind, const std::string &scientificName);
 };
 
 
@@ -0,0 +1,547 @@
+#include "httpclient.h"
+
+#include "util/curl.h"
+#include "util/configuration.h"
+#include "util/concat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+
+/**
+ * curl share handle for the DNS cache and TLS sessions, together with the per host request
+ * counters. Connections are not shared, as libcurl does not support using a shared connection
+ * cache from multiple threads; every thread keeps them in its own handles instead. The share is
+ * never destroyed, as handles of other threads may still use it during shutdown.
+ */
+class SharedConnections {
+public:
+	SharedConnections() : maxRequestsPerHost(static_cast<size_t>(std::max(1, Configuration::get<int>("http.maxconnectionsperhost", 8)))) {
+		curl_global_init(CURL_GLOBAL_DEFAULT);
+
+		share = curl_share_init();
+		curl_share_setopt(share, CURLSHOPT_LOCKFUNC, SharedConnections::lock);
+		curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, SharedConnections::unlock);
+		curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	}
+
+	static SharedConnections &get() {
+		static SharedConnections *shared = new SharedConnections();
+		return *shared;
+	}
+
+	/**
+	 * wait until a request to the host may start
+	 */
+	void acquire(const std::string &host) {
+		std::unique_lock<std::mutex> lock(hostsMutex);
+		hostsCondition.wait(lock, [this, &host]() {
+			return activeRequests[host] < maxRequestsPerHost;
+		});
+		++activeRequests[host];
+	}
+
+	void release(const std::string &host) {
+		{
+			std::lock_guard<std::mutex> lock(hostsMutex);
+			if(--activeRequests[host] == 0) {
+				activeRequests.erase(host);
+			}
+		}
+		hostsCondition.notify_all();
+	}
+
+	CURLSH *share;
+
+private:
+	static void lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userdata) {
+		reinterpret_cast<SharedConnections*>(userdata)->locks[data].lock();
+	}
+
+	static void unlock(CURL *handle, curl_lock_data data, void *userdata) {
+		reinterpret_cast<SharedConnections*>(userdata)->locks[data].unlock();
+	}
+
+	std::mutex locks[CURL_LOCK_DATA_LAST];
+
+	size_t maxRequestsPerHost;
+	std::mutex hostsMutex;
+	std::condition_variable hostsCondition;
+	std::map<std::string, size_t> activeRequests;
+};
+
+/**
+ * curl handle of the current thread, reused for all of its requests
+ */
+class ThreadHandle {
+public:
+	ThreadHandle() : handle(curl_easy_init()) {}
+	~ThreadHandle() {
+		curl_easy_cleanup(handle);
+	}
+
+	static CURL *get() {
+		thread_local ThreadHandle threadHandle;
+		return threadHandle.handle;
+	}
+
+private:
+	CURL *handle;
+};
+
+/**
+ * holds one of the request slots of a host
+ */
+class HostSlot {
+public:
+	explicit HostSlot(const std::string &url) : host(getHost(url)) {
+		SharedConnections::get().acquire(host);
+	}
+
+	~HostSlot() {
+		SharedConnections::get().release(host);
+	}
+
+private:
+	static std::string getHost(const std::string &url) {
+		size_t begin = url.find("://");
+		begin = begin == std::string::npos ? 0 : begin + 3;
+		size_t end = url.find_first_of("/?#", begin);
+		return url.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+	}
+
+	std::string host;
+};
+
+HttpClient::Request::Request(const std::string &url) : url(url), post(false), head(false), failOnError(false), timeout(0) {
+}
+
+HttpClient::Response::Response() : status(0) {
+}
+
+std::string HttpClient::Response::getHeader(const std::string &name) const {
+	std::string key = name;
+	std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+
+	auto it = headers.find(key);
+	return it == headers.end() ? "" : it->second;
+}
+
+size_t HttpClient::headerFunction(char *buffer, size_t size, size_t nitems, void *userdata) {
+	auto &response = *reinterpret_cast<Response*>(userdata);
+	std::string line(buffer, size * nitems);
+	while(!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+		line.pop_back();
+	}
+
+	if(line.compare(0, 5, "HTTP/") == 0) {
+		// new response, e.g. after a redirect
+		response.headers.clear();
+		return size * nitems;
+	}
+
+	size_t colon = line.find(':');
+	if(colon != std::string::npos) {
+		std::string name = line.substr(0, colon);
+		std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+		size_t valueBegin = line.find_first_not_of(' ', colon + 1);
+		response.headers[name] = valueBegin == std::string::npos ? "" : line.substr(valueBegin);
+	}
+
+	return size * nitems;
+}
+
+size_t HttpClient::bodyFunction(void *buffer, size_t size, size_t nmemb, void *userdata) {
+	reinterpret_cast<std::string*>(userdata)->append(static_cast<const char*>(buffer), size * nmemb);
+	return size * nmemb;
+}
+
+HttpClient::Response HttpClient::perform(const Request &request) {
+	HostSlot slot(request.url);
+
+	std::string body;
+	Response response = perform(request, HttpClient::bodyFunction, &body);
+	response.body = std::move(body);
+	return response;
+}
+
+struct curl_slist *HttpClient::setOptions(void *curl, const Request &request, Response &response,
+										 WriteFunction writeFunction, void *userdata, char *errorBuffer) {
+	std::string proxy = Configuration::get<std::string>("proxy", "");
+	curl_easy_setopt(curl, CURLOPT_SHARE, SharedConnections::get().share);
+	curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+	curl_easy_setopt(curl, CURLOPT_PROXY, proxy.c_str());
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+	curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errorBuffer);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HttpClient::headerFunction);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeFunction);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, userdata);
+
+	if(request.failOnError) {
+		curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+	}
+
+	if(request.timeout > 0) {
+		curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, request.timeout);
+	}
+
+	if(!request.userPassword.empty()) {
+		curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+		curl_easy_setopt(curl, CURLOPT_USERPWD, request.userPassword.c_str());
+	}
+
+	if(request.post) {
+		curl_easy_setopt(curl, CURLOPT_POST, 1L);
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.postFields.c_str());
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request.postFields.size()));
+	}
+
+	if(request.head) {
+		curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+	}
+
+	struct curl_slist *headers = nullptr;
+	for(auto &header : request.headers) {
+		headers = curl_slist_append(headers, header.c_str());
+	}
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+	return headers;
+}
+
+HttpClient::Response HttpClient::perform(const Request &request, WriteFunction writeFunction, void *userdata) {
+	// resetting the options keeps the connections and caches of the handle
+	CURL *curl = ThreadHandle::get();
+	curl_easy_reset(curl);
+
+	Response response;
+	char errorBuffer[CURL_ERROR_SIZE];
+	errorBuffer[0] = '\0';
+
+	struct curl_slist *headers = setOptions(curl, request, response, writeFunction, userdata, errorBuffer);
+
+	CURLcode result = curl_easy_perform(curl);
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+
+	// the handle must not keep pointers to the request data
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+	curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, nullptr);
+	curl_slist_free_all(headers);
+
+	if(result != CURLE_OK) {
+		throw cURLException(concat("HttpClient: request to ", request.url, " failed: ",
+								   errorBuffer[0] != '\0' ? errorBuffer : curl_easy_strerror(result)));
+	}
+
+	return response;
+}
+
+/**
+ * a running transfer of performAll
+ */
+struct MultiTransfer {
+	MultiTransfer() : curl(curl_easy_init()), index(0), headers(nullptr), twin(nullptr), hedged(false) {
+		errorBuffer[0] = '\0';
+	}
+
+	~MultiTransfer() {
+		curl_slist_free_all(headers);
+		curl_easy_cleanup(curl);
+	}
+
+	CURL *curl;
+	size_t index;
+	HttpClient::Response response;
+	std::string body;
+	struct curl_slist *headers;
+	char errorBuffer[CURL_ERROR_SIZE];
+	std::chrono::steady_clock::time_point started;
+
+	/**
+	 * the running duplicate of the same request, if any
+	 */
+	MultiTransfer *twin;
+
+	/**
+	 * true if a duplicate of the request was sent, so no further one is sent
+	 */
+	bool hedged;
+};
+
+/**
+ * multi handle of performAll, removes all running transfers when it is destroyed
+ */
+class MultiHandle {
+public:
+	MultiHandle() : multi(curl_multi_init()) {
+		curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+		curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(std::max(1, Configuration::get<int>("http.maxconnectionsperhost", 8))));
+	}
+
+	~MultiHandle() {
+		removeAll();
+		curl_multi_cleanup(multi);
+	}
+
+	/**
+	 * multi handle of the current thread, which keeps its connections between calls of performAll
+	 */
+	static MultiHandle &get() {
+		thread_local MultiHandle threadHandle;
+		return threadHandle;
+	}
+
+	void removeAll() {
+		for(MultiTransfer *transfer : running) {
+			curl_multi_remove_handle(multi, transfer->curl);
+		}
+		running.clear();
+	}
+
+	void add(MultiTransfer *transfer) {
+		curl_multi_add_handle(multi, transfer->curl);
+		running.insert(transfer);
+	}
+
+	void remove(MultiTransfer *transfer) {
+		curl_multi_remove_handle(multi, transfer->curl);
+		running.erase(transfer);
+	}
+
+	size_t size() const {
+		return running.size();
+	}
+
+	const std::set<MultiTransfer*> &getRunning() const {
+		return running;
+	}
+
+	CURLM *multi;
+
+private:
+	std::set<MultiTransfer*> running;
+};
+
+/**
+ * controller of performAll with a fixed number of concurrent transfers and without duplicates
+ */
+class FixedController : public HttpClient::Controller {
+public:
+	explicit FixedController(size_t limit) : limit(std::max<size_t>(limit, 1)), inFlight(0) {
+	}
+
+	bool acquire(bool) override {
+		// the controller is not shared, so waiting would never free a slot
+		if(inFlight >= limit) {
+			return false;
+		}
+		++inFlight;
+		return true;
+	}
+
+	void release() override {
+		--inFlight;
+	}
+
+	long getHedgeDelay() override {
+		return 0;
+	}
+
+	void onFinished(long, bool) override {
+	}
+
+private:
+	size_t limit;
+	size_t inFlight;
+};
+
+void HttpClient::performAll(const std::vector<Request> &requests, size_t maxInFlight, const Callback &callback) {
+	FixedController controller(maxInFlight);
+	performAll(requests, controller, callback);
+}
+
+void HttpClient::performAll(const std::vector<Request> &requests, Controller &controller, const Callback &callback) {
+	using Clock = std::chrono::steady_clock;
+
+	// transfers are created on demand, as the limit of the controller may change
+	std::vector<std::unique_ptr<MultiTransfer>> transfers;
+	std::vector<MultiTransfer*> idle;
+
+	// the guard is declared after the transfers, so their handles are removed before they are cleaned up
+	MultiHandle &handle = MultiHandle::get();
+	struct RemoveGuard {
+		MultiHandle &handle;
+		Controller &controller;
+		~RemoveGuard() {
+			for(size_t i = 0; i < handle.size(); ++i) {
+				controller.release();
+			}
+			handle.removeAll();
+		}
+	} removeGuard {handle, controller};
+	size_t next = 0;
+
+	auto start = [&](size_t index) -> MultiTransfer* {
+		if(idle.empty()) {
+			transfers.emplace_back(new MultiTransfer());
+			idle.push_back(transfers.back().get());
+		}
+		MultiTransfer &transfer = *idle.back();
+		idle.pop_back();
+
+		curl_easy_reset(transfer.curl);
+		curl_slist_free_all(transfer.headers);
+		transfer.index = index;
+		transfer.response = Response();
+		transfer.body.clear();
+		transfer.errorBuffer[0] = '\0';
+		transfer.twin = nullptr;
+		transfer.hedged = false;
+		transfer.started = Clock::now();
+		transfer.headers = setOptions(transfer.curl, requests[index], transfer.response,
+									  HttpClient::bodyFunction, &transfer.body, transfer.errorBuffer);
+
+		// wait for a connection that allows multiplexing instead of opening a new one
+		curl_easy_setopt(transfer.curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+		curl_easy_setopt(transfer.curl, CURLOPT_PIPEWAIT, 1L);
+		curl_easy_setopt(transfer.curl, CURLOPT_PRIVATE, &transfer);
+		handle.add(&transfer);
+		return &transfer;
+	};
+
+	auto release = [&](MultiTransfer *transfer) {
+		handle.remove(transfer);
+		controller.release();
+		idle.push_back(transfer);
+	};
+
+	while(next < requests.size() || handle.size() > 0) {
+		// without running transfers of its own, the call waits for slots released by other calls
+		while(next < requests.size() && controller.acquire(handle.size() == 0)) {
+			start(next++);
+		}
+
+		if(handle.size() == 0) {
+			for(; next < requests.size(); ++next) {
+				Response response;
+				callback(next, response, std::make_exception_ptr(cURLException(
+						concat("HttpClient: request to ", requests[next].url, " was not sent, the server is unavailable"))));
+			}
+			break;
+		}
+
+		// send a duplicate of requests that take unusually long, within the limit of concurrent transfers
+		long hedgeDelay = controller.getHedgeDelay();
+		if(hedgeDelay > 0) {
+			auto deadline = Clock::now() - std::chrono::milliseconds(hedgeDelay);
+			std::vector<MultiTransfer*> slow;
+			for(MultiTransfer *transfer : handle.getRunning()) {
+				if(!transfer->hedged && transfer->started <= deadline) {
+					slow.push_back(transfer);
+				}
+			}
+			for(size_t i = 0; i < slow.size() && controller.acquire(false); ++i) {
+				MultiTransfer *duplicate = start(slow[i]->index);
+				duplicate->twin = slow[i];
+				duplicate->hedged = true;
+				slow[i]->twin = duplicate;
+				slow[i]->hedged = true;
+			}
+		}
+
+		int runningTransfers;
+		curl_multi_perform(handle.multi, &runningTransfers);
+
+		int messages;
+		bool finished = false;
+		while(CURLMsg *message = curl_multi_info_read(handle.multi, &messages)) {
+			if(message->msg != CURLMSG_DONE) {
+				continue;
+			}
+
+			MultiTransfer *transfer;
+			curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&transfer));
+			CURLcode result = message->data.result;
+			if(handle.getRunning().count(transfer) == 0) {
+				// cancelled because its duplicate finished first
+				continue;
+			}
+			handle.remove(transfer);
+			controller.release();
+			finished = true;
+
+			curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &transfer->response.status);
+			long status = transfer->response.status;
+			bool success = result == CURLE_OK && status < 500 && status != 429;
+			long latency = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - transfer->started).count());
+			if(!success) {
+				controller.onFinished(latency, false);
+			}
+
+			MultiTransfer *twin = transfer->twin;
+			if(twin != nullptr) {
+				twin->twin = nullptr;
+				if(!success) {
+					// the duplicate may still succeed
+					idle.push_back(transfer);
+					continue;
+				}
+				release(twin);
+			}
+
+			std::exception_ptr error;
+			if(result != CURLE_OK) {
+				error = std::make_exception_ptr(cURLException(concat("HttpClient: request to ", requests[transfer->index].url, " failed: ",
+						transfer->errorBuffer[0] != '\0' ? transfer->errorBuffer : curl_easy_strerror(result))));
+			} else {
+				transfer->response.body = std::move(transfer->body);
+			}
+
+			idle.push_back(transfer);
+			bool usable = callback(transfer->index, transfer->response, error);
+
+			// successful transfers are reported once the callback checked the response
+			if(success) {
+				controller.onFinished(latency, usable);
+			}
+		}
+
+		if(handle.size() > 0 && !finished) {
+			// wake up in time to send duplicates of slow requests
+			long timeout = hedgeDelay > 0 ? std::min(1000L, std::max(10L, hedgeDelay / 4)) : 1000L;
+			if(next < requests.size()) {
+				// slots released by other calls do not wake up the wait
+				timeout = std::min(timeout, 50L);
+			}
+			curl_multi_wait(handle.multi, nullptr, 0, static_cast<int>(timeout), nullptr);
+		}
+	}
+}
+
+std::string HttpClient::escape(const std::string &value) {
+	static const char *hex = "0123456789ABCDEF";
+
+	std::string escaped;
+	escaped.reserve(value.size());
+	for(char c : value) {
+		unsigned char u = static_cast<unsigned char>(c);
+		if(isalnum(u) || c == '-' || c == '_' || c == '.' || c == '~') {
+			escaped += c;
+		} else {
+			escaped += '%';
+			escaped += hex[u >> 4];
+			escaped += hex[u & 15];
+		}
+	}
+	return escaped;
+}
@@ -0,0 +1,173 @@
+#ifndef UTIL_HTTPCLIENT_H_
+#define UTIL_HTTPCLIENT_H_
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Process wide HTTP client for all requests of the module to upstream services.
+ *
+ * All requests share one DNS cache and TLS session cache. Every thread reuses its own curl
+ * handles, which keep their connections, so consecutive requests of a thread to a host reuse
+ * keep-alive connections, and new connections resume TLS sessions instead of full handshakes.
+ * Responses are requested with gzip/deflate content encoding.
+ *
+ * Only buffered requests are limited to `http.maxconnectionsperhost` concurrent requests
+ * per host in the whole process. Streamed transfers are paced by their consumer, which
+ * may itself wait for other requests to the same host, so they are not limited. The
+ * transfers of performAll are bounded by its controller instead, waiting for a process
+ * wide slot would block the event loop with its own transfers; the setting only caps the
+ * connections of the calling thread to a host.
+ *
+ * Many small requests can be performed concurrently by one thread with performAll, which
+ * drives all transfers from a single event loop and multiplexes them over HTTP/2
+ * connections where the server supports it.
+ *
+ * Transport errors are reported as cURLException.
+ */
+class HttpClient {
+public:
+	class Request {
+	public:
+		explicit Request(const std::string &url);
+
+		std::string url;
+		std::vector<std::string> headers;
+
+		/**
+		 * credentials for basic authentication as "user:password", none if empty
+		 */
+		std::string userPassword;
+
+		bool post;
+		std::string postFields;
+
+		/**
+		 * request only the headers of the response
+		 */
+		bool head;
+
+		/**
+		 * treat http status codes >= 400 as errors
+		 */
+		bool failOnError;
+
+		/**
+		 * the maximum duration of the request in milliseconds, 0 for no limit
+		 */
+		long timeout;
+	};
+
+	class Response {
+	public:
+		Response();
+
+		long status;
+		std::string body;
+
+		/**
+		 * @return the value of the header of the final response, empty if it is missing
+		 */
+		std::string getHeader(const std::string &name) const;
+
+	private:
+		friend class HttpClient;
+
+		/**
+		 * headers by lower case name
+		 */
+		std::map<std::string, std::string> headers;
+	};
+
+	typedef size_t (*WriteFunction)(void *buffer, size_t size, size_t nmemb, void *userdata);
+
+	/**
+	 * perform the request and collect the response body, waiting for a free slot of the host
+	 */
+	static Response perform(const Request &request);
+
+	/**
+	 * perform the request and pass the response body to the write function, without the
+	 * limit of requests per host. The transfer is aborted if the write function does not consume all data.
+	 * @return the response without body
+	 */
+	static Response perform(const Request &request, WriteFunction writeFunction, void *userdata);
+
+	/**
+	 * called for every finished request of performAll with the index of the request.
+	 * error is set if the transfer failed.
+	 * @return false if the response is unusable, e.g. a malformed body, which counts as a failed transfer
+	 */
+	typedef std::function<bool(size_t index, Response &response, std::exception_ptr error)> Callback;
+
+	/**
+	 * Controls the concurrency of performAll. Every transfer acquires a slot before it is
+	 * started and releases it when it ends, the controller is informed about every finished
+	 * transfer. A controller may be shared by several calls of performAll, even on different
+	 * threads, to limit their transfers in total.
+	 */
+	class Controller {
+	public:
+		virtual ~Controller() = default;
+
+		/**
+		 * @param wait block until a slot is free instead of failing right away
+		 * @return false if no transfer may be started, with wait only if no more transfers
+		 *         are allowed at all
+		 */
+		virtual bool acquire(bool wait) = 0;
+
+		/**
+		 * free the slot of a transfer that ended
+		 */
+		virtual void release() = 0;
+
+		/**
+		 * @return the milliseconds after which a duplicate of a running request is sent, 0 for none
+		 */
+		virtual long getHedgeDelay() = 0;
+
+		/**
+		 * @param latency the duration of the transfer in milliseconds
+		 * @param success false on transport errors, server overload (5xx and 429 responses) and
+		 *        responses the callback rejected
+		 */
+		virtual void onFinished(long latency, bool success) = 0;
+	};
+
+	/**
+	 * perform the requests concurrently on the calling thread and collect their response bodies
+	 * @param maxInFlight the maximum number of concurrent transfers
+	 * @param callback called on the calling thread as soon as a request is finished
+	 */
+	static void performAll(const std::vector<Request> &requests, size_t maxInFlight, const Callback &callback);
+
+	/**
+	 * perform the requests concurrently as directed by the controller. A request whose
+	 * duplicate is still running only fails if the duplicate fails as well. Requests that
+	 * cannot be started because the controller allows no transfers fail immediately.
+	 */
+	static void performAll(const std::vector<Request> &requests, Controller &controller, const Callback &callback);
+
+	/**
+	 * percent-encode a value for a URL query
+	 */
+	static std::string escape(const std::string &value);
+
+private:
+	/**
+	 * set the options of the request on the handle
+	 * @return the header list, to be freed after the transfer
+	 */
+	static struct curl_slist *setOptions(void *curl, const Request &request, Response &response,
+										 WriteFunction writeFunction, void *userdata, char *errorBuffer);
+
+	static size_t headerFunction(char *buffer, size_t size, size_t nitems, void *userdata);
+	static size_t bodyFunction(void *buffer, size_t size, size_t nmemb, void *userdata);
+};
+
+#endif /* UTIL_HTTPCLIENT_H_ */
@@ -0,0 +1,96 @@
+#include "iucnrangecache.h"
+
+#include "util/gfbiodatautil.h"
+#include "util/filecache.h"
+#include "util/configuration.h"
+#include "util/concat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+const std::vector<double> IUCNRangeCache::levelTolerances {0.0, 0.01, 0.05, 0.25, 1.0};
+
+size_t IUCNRangeCache::selectLevel(const QueryRectangle &rect) {
+	if(rect.restype != QueryResolution::Type::PIXELS || rect.xres == 0 || rect.yres == 0) {
+		return 0;
+	}
+
+	// simplification below the size of a pixel is not visible
+	double pixelSize = std::min((rect.x2 - rect.x1) / rect.xres, (rect.y2 - rect.y1) / rect.yres);
+
+	size_t level = 0;
+	for(size_t i = 1; i < levelTolerances.size(); ++i) {
+		if(levelTolerances[i] <= pixelSize) {
+			level = i;
+		}
+	}
+
+	return level;
+}
+
+std::vector<std::string> IUCNRangeCache::loadRangesFromDatabase(pqxx::connection &connection, std::string &scientificName, const std::vector<size_t> &levels) {
+	std::string taxa = GFBioDataUtil::resolveTaxaNames(connection, scientificName);
+
+	// build the requested levels of the pyramid within one query
+	std::stringstream query;
+	query << "SELECT ";
+	for(size_t i = 0; i < levels.size(); ++i) {
+		if(i > 0) {
+			query << ", ";
+		}
+		if(levels[i] == 0) {
+			query << "ST_AsEWKT(geom)";
+		} else {
+			query << "ST_AsEWKT(ST_SimplifyPreserveTopology(geom, " << levelTolerances[levels[i]] << "))";
+		}
+	}
+	query << " FROM (SELECT ST_Collect(geom) geom FROM iucn.expert_ranges_all WHERE lower(binomial) = ANY ($1)) ranges";
+
+	connection.prepare("occurrences", query.str());
+
+	pqxx::work work(connection);
+	pqxx::result result = work.prepared("occurrences")(taxa).exec();
+	work.commit();
+
+	std::vector<std::string> wkts;
+	for(size_t i = 0; i < levels.size(); ++i) {
+		wkts.push_back(result[0][i].as<std::string>());
+	}
+
+	return wkts;
+}
+
+std::string IUCNRangeCache::getRangesWKT(pqxx::connection &connection, std::string &scientificName, const QueryRectangle &rect) {
+	size_t level = selectLevel(rect);
+
+	std::string cachePath = Configuration::get<std::string>("gfbio.iucn.cachepath", "");
+	if(cachePath.empty()) {
+		// without the cache, only the requested level is simplified and transferred
+		return loadRangesFromDatabase(connection, scientificName, std::vector<size_t> {level})[0];
+	}
+
+	std::string species = scientificName;
+	std::transform(species.begin(), species.end(), species.begin(), [](char c) {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	});
+
+	FileCache cache(concat(cachePath, "/", FileCache::sanitize(species)));
+
+	std::string wkt;
+	if(cache.get(concat(level, ".wkt"), wkt)) {
+		return wkt;
+	}
+
+	std::vector<size_t> allLevels;
+	for(size_t i = 0; i < levelTolerances.size(); ++i) {
+		allLevels.push_back(i);
+	}
+
+	std::vector<std::string> levels = loadRangesFromDatabase(connection, scientificName, allLevels);
+	for(size_t i = 0; i < levels.size(); ++i) {
+		cache.put(concat(i, ".wkt"), levels[i]);
+	}
+
+	return levels[level];
+}
@@ -0,0 +1,47 @@
+#ifndef UTIL_IUCNRANGECACHE_H_
+#define UTIL_IUCNRANGECACHE_H_
+
+#include "datatypes/spatiotemporal.h"
+
+#include <string>
+#include <vector>
+#include <pqxx/pqxx>
+
+/**
+ * Local cache for IUCN expert ranges.
+ *
+ * The ranges of a species are stored on disk as a pyramid of simplified geometries,
+ * one per level. Level 0 holds the original geometry, every further level is simplified
+ * with a coarser tolerance. Queries are answered from the coarsest level whose
+ * simplification error stays below the pixel size of the query. The database is only
+ * queried if the species is not cached yet; in that case all levels are built at once.
+ *
+ * The cache is disabled if `gfbio.iucn.cachepath` is not configured. Then only the
+ * requested level is built for every query.
+ */
+class IUCNRangeCache {
+public:
+	/**
+	 * get the expert ranges of the species as EWKT in the level of detail suitable for the query
+	 */
+	static std::string getRangesWKT(pqxx::connection &connection, std::string &scientificName, const QueryRectangle &rect);
+
+	/**
+	 * @return the level of the pyramid to use for the query
+	 */
+	static size_t selectLevel(const QueryRectangle &rect);
+
+	/**
+	 * simplification tolerance (in degrees) of the pyramid levels, starting with the original geometry
+	 */
+	static const std::vector<double> levelTolerances;
+
+private:
+	/**
+	 * @param levels the levels of the pyramid to build
+	 * @return the EWKT of the levels, in the given order
+	 */
+	static std::vector<std::string> loadRangesFromDatabase(pqxx::connection &connection, std::string &scientificName, const std::vector<size_t> &levels);
+};
+
+#endif /* UTIL_IUCNRANGECACHE_H_ */
@@ -0,0 +1,241 @@
+#include "jsonextractor.h"
+
+#include "util/stringsplit.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * scanner over the document, keeps the position and the number of paths not found yet
+ */
+class JsonExtractor::Scanner {
+public:
+	Scanner(const char *begin, const char *end, size_t remaining) : position(begin), end(end), remaining(remaining) {
+	}
+
+	/**
+	 * read the value at the position, parsing it if it is selected and descending into it
+	 * if it contains selected values
+	 */
+	bool visit(const Node &node, Json::Value &target) {
+		skipWhitespace();
+		if(position >= end) {
+			return false;
+		}
+
+		if(node.selected) {
+			const char *begin = position;
+			Json::Reader reader;
+			if(!skipValue() || !reader.parse(begin, position, target, false)) {
+				return false;
+			}
+			--remaining;
+			return true;
+		}
+
+		if(*position == '{') {
+			if(target.isNull()) {
+				target = Json::Value(Json::objectValue);
+			}
+			return visitContainer('}', [&](size_t) -> bool {
+				std::string key;
+				if(!readKey(key)) {
+					return false;
+				}
+				skipWhitespace();
+				if(position >= end || *position != ':') {
+					return false;
+				}
+				++position;
+
+				auto child = node.children.find(key);
+				return child == node.children.end() ? skipValue() : visit(child->second, target[key]);
+			});
+		}
+
+		if(*position == '[') {
+			if(target.isNull()) {
+				target = Json::Value(Json::arrayValue);
+			}
+			return visitContainer(']', [&](size_t index) -> bool {
+				auto child = node.children.find(std::to_string(index));
+				return child == node.children.end() ? skipValue() : visit(child->second, target[static_cast<Json::ArrayIndex>(index)]);
+			});
+		}
+
+		return skipValue();
+	}
+
+	/**
+	 * @return true if only whitespace is left
+	 */
+	bool isAtEnd() {
+		skipWhitespace();
+		return position == end;
+	}
+
+	bool isDone() const {
+		return remaining == 0;
+	}
+
+private:
+	template<typename Visitor>
+	bool visitContainer(char close, const Visitor &visitor) {
+		++position;
+		skipWhitespace();
+		if(position < end && *position == close) {
+			++position;
+			return true;
+		}
+
+		for(size_t index = 0; ; ++index) {
+			if(!visitor(index)) {
+				return false;
+			}
+			if(remaining == 0) {
+				// the rest of the document is not needed
+				return true;
+			}
+
+			skipWhitespace();
+			if(position >= end) {
+				return false;
+			}
+			if(*position == close) {
+				++position;
+				return true;
+			}
+			if(*position != ',') {
+				return false;
+			}
+			++position;
+		}
+	}
+
+	void skipWhitespace() {
+		while(position < end && (*position == ' ' || *position == '\n' || *position == '\r' || *position == '\t')) {
+			++position;
+		}
+	}
+
+	bool skipString() {
+		++position;
+		while(position < end) {
+			char c = *position++;
+			if(c == '\\') {
+				++position;
+			} else if(c == '"') {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * skip the value at the position, the content of skipped containers is not validated
+	 */
+	bool skipValue() {
+		skipWhitespace();
+		if(position >= end) {
+			return false;
+		}
+
+		if(*position == '"') {
+			return skipString();
+		}
+
+		if(*position == '{' || *position == '[') {
+			size_t depth = 0;
+			while(position < end) {
+				char c = *position;
+				if(c == '"') {
+					if(!skipString()) {
+						return false;
+					}
+					continue;
+				}
+
+				++position;
+				if(c == '{' || c == '[') {
+					++depth;
+				} else if((c == '}' || c == ']') && --depth == 0) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// number or literal
+		const char *begin = position;
+		while(position < end && strchr(",}] \n\r\t", *position) == nullptr) {
+			++position;
+		}
+		return position > begin;
+	}
+
+	bool readKey(std::string &key) {
+		skipWhitespace();
+		if(position >= end || *position != '"') {
+			return false;
+		}
+
+		const char *begin = position;
+		if(!skipString()) {
+			return false;
+		}
+
+		if(std::find(begin + 1, position - 1, '\\') == position - 1) {
+			key.assign(begin + 1, position - 1);
+			return true;
+		}
+
+		// let the reader decode the escape sequences
+		Json::Reader reader;
+		Json::Value value;
+		if(!reader.parse(begin, position, value, false)) {
+			return false;
+		}
+		key = value.asString();
+		return true;
+	}
+
+	const char *position;
+	const char *end;
+	size_t remaining;
+};
+
+JsonExtractor::JsonExtractor(const std::vector<std::string> &paths) : paths(0) {
+	// a path is added after the paths to its ancestors, so values inside a selected value are not counted
+	std::vector<std::string> sorted(paths);
+	std::sort(sorted.begin(), sorted.end(), [](const std::string &a, const std::string &b) { return a.size() < b.size(); });
+
+	for(auto &path : sorted) {
+		Node *node = &root;
+		bool covered = root.selected;
+		if(!path.empty()) {
+			for(auto &component : split(path, '.')) {
+				node = &node->children[component];
+				covered = covered || node->selected;
+			}
+		}
+
+		// values inside a selected value are parsed with it
+		if(!covered) {
+			node->selected = true;
+			++this->paths;
+		}
+	}
+}
+
+bool JsonExtractor::extract(const std::string &json, Json::Value &document) const {
+	return extract(json.data(), json.data() + json.size(), document);
+}
+
+bool JsonExtractor::extract(const char *begin, const char *end, Json::Value &document) const {
+	document = Json::Value();
+	Scanner scanner(begin, end, paths);
+	if(!scanner.visit(root, document)) {
+		return false;
+	}
+	return scanner.isDone() || scanner.isAtEnd();
+}
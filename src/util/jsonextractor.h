@@ -0,0 +1,48 @@
+#ifndef UTIL_JSONEXTRACTOR_H_
+#define UTIL_JSONEXTRACTOR_H_
+
+#include <json/json.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Extracts selected parts of a JSON document without building the tree of the whole document.
+ *
+ * Paths are member names and array indices separated by dots, e.g. `results.0`. The document
+ * is scanned once: values that are not on a path are skipped without allocations, only the
+ * values at the paths are parsed. Scanning stops as soon as all paths were found, so the rest
+ * of the document is neither read nor validated.
+ *
+ * The result is the document pruned to the paths, i.e. the containers on the paths with only
+ * the selected members and elements, so it can be read like the full document.
+ */
+class JsonExtractor {
+public:
+	explicit JsonExtractor(const std::vector<std::string> &paths);
+
+	/**
+	 * @param document set to the document pruned to the paths
+	 * @return false if the scanned part of the document is malformed
+	 */
+	bool extract(const std::string &json, Json::Value &document) const;
+	bool extract(const char *begin, const char *end, Json::Value &document) const;
+
+private:
+	/**
+	 * a path component, the root of the tree is the document
+	 */
+	struct Node {
+		Node() : selected(false) {}
+
+		bool selected;
+		std::map<std::string, Node> children;
+	};
+
+	class Scanner;
+
+	Node root;
+	size_t paths;
+};
+
+#endif /* UTIL_JSONEXTRACTOR_H_ */
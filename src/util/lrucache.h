@@ -0,0 +1,85 @@
+#ifndef UTIL_LRUCACHE_H_
+#define UTIL_LRUCACHE_H_
+
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * Thread safe in-memory cache with a maximum number of entries and a time to live.
+ * If the cache is full, the least recently used entry is evicted.
+ */
+template<typename Key, typename Value>
+class LRUCache {
+public:
+	/**
+	 * @param capacity the maximum number of entries, 0 disables the cache
+	 * @param ttl the duration an entry is valid
+	 */
+	LRUCache(size_t capacity, std::chrono::seconds ttl) : capacity(capacity), ttl(ttl) {
+	}
+
+	LRUCache(const LRUCache&) = delete;
+	LRUCache &operator=(const LRUCache&) = delete;
+
+	/**
+	 * @return false if there is no valid entry for the key
+	 */
+	bool get(const Key &key, Value &value) {
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = index.find(key);
+		if(it == index.end()) {
+			return false;
+		}
+
+		if(it->second->expires <= Clock::now()) {
+			entries.erase(it->second);
+			index.erase(it);
+			return false;
+		}
+
+		// mark as most recently used
+		entries.splice(entries.begin(), entries, it->second);
+		value = it->second->value;
+		return true;
+	}
+
+	void put(const Key &key, const Value &value) {
+		if(capacity == 0) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = index.find(key);
+		if(it != index.end()) {
+			entries.erase(it->second);
+			index.erase(it);
+		}
+
+		entries.push_front(Entry {key, value, Clock::now() + ttl});
+		index[key] = entries.begin();
+
+		while(entries.size() > capacity) {
+			index.erase(entries.back().key);
+			entries.pop_back();
+		}
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Entry {
+		Key key;
+		Value value;
+		Clock::time_point expires;
+	};
+
+	std::mutex mutex;
+	size_t capacity;
+	std::chrono::seconds ttl;
+	std::list<Entry> entries;
+	std::unordered_map<Key, typename std::list<Entry>::iterator> index;
+};
+
+#endif /* UTIL_LRUCACHE_H_ */
@@ -0,0 +1,41 @@
+#include "mappedfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char *data, size_t size) : data(data), size(size) {
+}
+
+MappedFile::~MappedFile() {
+	munmap(const_cast<char*>(data), size);
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string &path) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		return nullptr;
+	}
+
+	std::unique_ptr<MappedFile> file;
+	struct stat status;
+	if(fstat(fd, &status) == 0 && status.st_size > 0) {
+		size_t size = static_cast<size_t>(status.st_size);
+		void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapped != MAP_FAILED) {
+			file.reset(new MappedFile(static_cast<const char*>(mapped), size));
+		}
+	}
+
+	::close(fd);
+	return file;
+}
+
+const char *MappedFile::getData() const {
+	return data;
+}
+
+size_t MappedFile::getSize() const {
+	return size;
+}
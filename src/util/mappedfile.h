@@ -0,0 +1,33 @@
+#ifndef UTIL_MAPPEDFILE_H_
+#define UTIL_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * Read only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	/**
+	 * @return the mapping or nullptr if the file does not exist, is empty or cannot be mapped
+	 */
+	static std::unique_ptr<MappedFile> open(const std::string &path);
+
+	const char *getData() const;
+	size_t getSize() const;
+
+private:
+	MappedFile(const char *data, size_t size);
+
+	const char *data;
+	size_t size;
+};
+
+#endif /* UTIL_MAPPEDFILE_H_ */
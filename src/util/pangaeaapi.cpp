@@ -6,6 +6,16 @@
 #include "util/curl.h"
 #include "util/configuration.h"
 #include "util/exceptions.h"
+#include "util/make_unique.h"
+#include "util/filecache.h"
+#include "util/sharedcache.h"
+#include "util/singleflight.h"
+#include "util/httpclient.h"
+#include "util/jsonextractor.h"
+#include "util/lrucache.h"
+
+#include <ctime>
+#include <cstdlib>
 
 PangaeaAPI::Parameter::Parameter(const Json::Value &json, const std::vector<Parameter> &parameters) {
 	name = json.get("name", "").asString();
@@ -56,30 +66,112 @@ std::vector<PangaeaAPI::Parameter> PangaeaAPI::parseParameters(const Json::Value
 	return parameters;
 }
 
-Json::Value PangaeaAPI::getMetaDataFromPangaea(const std::string &dataSetDOI) {
-	// get parameters from pangae
-	std::stringstream data;
-	cURL curl;
-	curl.setOpt(CURLOPT_PROXY, Configuration::get<std::string>("proxy", "").c_str());
-	curl.setOpt(CURLOPT_URL, concat("https://doi.pangaea.de/", dataSetDOI, "?format=metadata_jsonld").c_str());
-	curl.setOpt(CURLOPT_WRITEFUNCTION, cURL::defaultWriteFunction);
-	curl.setOpt(CURLOPT_WRITEDATA, &data);
+std::unique_ptr<FileCache> PangaeaAPI::getResponseCache() {
+	// without a configured cache directory, responses are only shared by the workers of the node
+	std::string cachePath = Configuration::get<std::string>("pangaea.cache.path", "");
+	if(!cachePath.empty()) {
+		return make_unique<FileCache>(cachePath);
+	}
+
+	std::string sharedPath = SharedCache::getDirectory("pangaea");
+	if(sharedPath.empty()) {
+		return nullptr;
+	}
+	return make_unique<FileCache>(sharedPath, static_cast<size_t>(Configuration::get<int>("sharedcache.size", 64)) * 1024 * 1024);
+}
+
+bool PangaeaAPI::readCacheEntry(FileCache &cache, const std::string &dataSetDOI, const std::string &format, Json::Value &entry) {
+	std::string serialized;
+	Json::Reader reader(Json::Features::strictMode());
+	return cache.get(concat(dataSetDOI, ".", format, ".json"), serialized) && reader.parse(serialized, entry) && entry.isMember("body");
+}
+
+std::string PangaeaAPI::getFromPangaea(const std::string &dataSetDOI, const std::string &format) {
+	std::unique_ptr<FileCache> cache = getResponseCache();
+	std::string cacheKey = concat(dataSetDOI, ".", format, ".json");
+
+	// cache entry: body, validators and time of the last successful (re)validation
+	Json::Value entry(Json::objectValue);
+	bool cached = false;
+	if(cache) {
+		cached = readCacheEntry(*cache, dataSetDOI, format, entry);
+
+		time_t ttl = Configuration::get<int>("pangaea.cache.ttl", 86400);
+		if(cached && time(nullptr) - entry.get("fetched", 0).asInt64() < ttl) {
+			return entry["body"].asString();
+		}
+	}
+
+	HttpClient::Request request(concat("https://doi.pangaea.de/", dataSetDOI, "?format=", format));
 
+	// conditional request for revalidating the cached entry
+	if(cached && !entry.get("etag", "").asString().empty()) {
+		request.headers.push_back(concat("If-None-Match: ", entry["etag"].asString()));
+	}
+	if(cached && !entry.get("lastModified", "").asString().empty()) {
+		request.headers.push_back(concat("If-Modified-Since: ", entry["lastModified"].asString()));
+	}
+
+	HttpClient::Response response;
 	try {
-		curl.perform();
+		response = HttpClient::perform(request);
+	} catch (const cURLException&) {
+		if(cached) {
+			// serve the stale entry while pangaea is unreachable
+			return entry["body"].asString();
+		}
+		throw;
+	}
+
+	if(cached && response.status == 304) {
+		entry["fetched"] = static_cast<Json::Int64>(time(nullptr));
+	} else if(cached && response.status != 200) {
+		return entry["body"].asString();
+	} else if(response.status != 200) {
+		// e.g. the error page of an unknown data set
+		throw cURLException(concat("PangaeaAPI: request for ", dataSetDOI, " failed with status ", response.status));
+	} else {
+		entry["body"] = response.body;
+		entry["etag"] = response.getHeader("ETag");
+		entry["lastModified"] = response.getHeader("Last-Modified");
+		entry["fetched"] = static_cast<Json::Int64>(time(nullptr));
+	}
+
+	if(cache && (response.status == 200 || response.status == 304)) {
+		Json::FastWriter writer;
+		cache->put(cacheKey, writer.write(entry));
+	}
+
+	return entry["body"].asString();
+}
+
+Json::Value PangaeaAPI::getMetaDataFromPangaea(const std::string &dataSetDOI) {
+	// get parameters from pangaea
+	std::string data;
+	try {
+		data = getFromPangaea(dataSetDOI, "metadata_jsonld");
 	} catch (const cURLException&) {
 		throw std::runtime_error(concat("PangaeaAPI: could not retrieve metadata from pangaea doi ", dataSetDOI));
 	}
 
-	Json::Reader reader(Json::Features::strictMode());
 	Json::Value jsonResponse;
-	if (!reader.parse(data.str(), jsonResponse))
+	if (!parseMetaData(data, jsonResponse))
 		throw std::runtime_error(concat("PangaeaAPI: could not parse metadata from pangaea dataset ", dataSetDOI));
 
 	return jsonResponse;
 }
 
+bool PangaeaAPI::parseMetaData(const std::string &data, Json::Value &json) {
+	// the JSON-LD also lists the citation, keywords and related data sets, which are not needed
+	static const JsonExtractor extractor({"variableMeasured", "spatialCoverage", "license", "url", "creator", "name", "distribution"});
+
+	return extractor.extract(data, json) && json.isObject();
+}
+
 void PangaeaAPI::MetaData::initSpatialCoverage(const Json::Value &json) {
+	hasSpatialCoverageBounds = false;
+	coverageX1 = coverageY1 = coverageX2 = coverageY2 = 0.0;
+
 	if(!json.isMember("spatialCoverage")) {
         spatialCoverageType = SpatialCoverageType ::NONE;
     } else {
@@ -94,6 +186,12 @@ void PangaeaAPI::MetaData::initSpatialCoverage(const Json::Value &json) {
                 y1 = std::stod(box[0]);
                 x2 = std::stod(box[3]);
                 y2 = std::stod(box[2]);
+
+                hasSpatialCoverageBounds = geo.isMember("box");
+                coverageX1 = x1;
+                coverageY1 = y1;
+                coverageX2 = x2;
+                coverageY2 = y2;
             } catch (...) {
                 x1 = 0.0;
                 y1 = 0.0;
@@ -110,12 +208,32 @@ void PangaeaAPI::MetaData::initSpatialCoverage(const Json::Value &json) {
 
             spatialCoverageType = SpatialCoverageType::POINT;
             spatialCoverageWKT = concat("POINT(", lon, " ", lat, ")");
+
+            hasSpatialCoverageBounds = geo.isMember("longitude") && geo.isMember("latitude");
+            coverageX1 = coverageX2 = lon;
+            coverageY1 = coverageY2 = lat;
         } else {
             spatialCoverageType = SpatialCoverageType::NONE;
         }
     }
 }
 
+bool PangaeaAPI::MetaData::intersectsSpatialCoverage(double x1, double y1, double x2, double y2) const {
+	if(spatialCoverageType == SpatialCoverageType::NONE || !hasSpatialCoverageBounds) {
+		return true;
+	}
+
+	if(coverageY2 < y1 || coverageY1 > y2) {
+		return false;
+	}
+
+	if(coverageX1 <= coverageX2) {
+		return coverageX2 >= x1 && coverageX1 <= x2;
+	}
+
+	// the box crosses the antimeridian
+	return coverageX1 <= x2 || coverageX2 >= x1;
+}
 
 PangaeaAPI::MetaData::MetaData(const Json::Value &json): parameters(parseParameters(json)) {
 	initSpatialCoverage(json);
@@ -163,29 +281,53 @@ void PangaeaAPI::MetaData::parseFormat(const Json::Value &json) {
 
 
 PangaeaAPI::MetaData PangaeaAPI::getMetaData(const std::string &dataSetDOI) {
-	Json::Value json = PangaeaAPI::getMetaDataFromPangaea(dataSetDOI);
+	// concurrent requests for the same data set share one request and its parsed result
+	static SingleFlight<std::string, PangaeaAPI::MetaData> flights;
+
+	// the parsed metadata is kept as long as the cached response is not revalidated
+	static LRUCache<std::string, std::shared_ptr<const PangaeaAPI::MetaData>> cache(
+			static_cast<size_t>(std::max(0, Configuration::get<int>("pangaea.metadata.entries", 1000))),
+			std::chrono::seconds(Configuration::get<int>("pangaea.cache.ttl", 86400)));
+
+	std::shared_ptr<const PangaeaAPI::MetaData> metaData;
+	if(cache.get(dataSetDOI, metaData)) {
+		return *metaData;
+	}
 
-	PangaeaAPI::MetaData metaData(json);
+	return flights.run(dataSetDOI, [&dataSetDOI]() -> PangaeaAPI::MetaData {
+		Json::Value json = PangaeaAPI::getMetaDataFromPangaea(dataSetDOI);
 
-	return metaData;
+		auto parsed = std::make_shared<const PangaeaAPI::MetaData>(json);
+		cache.put(dataSetDOI, parsed);
+		return *parsed;
+	});
 }
 
-std::string PangaeaAPI::getCitation(const std::string &dataSetDOI) {
-	// get parameters from pangaea
-	std::stringstream data;
-	cURL curl;
-	curl.setOpt(CURLOPT_PROXY, Configuration::get<std::string>("proxy", "").c_str());
-	curl.setOpt(CURLOPT_URL, concat("https://doi.pangaea.de/", dataSetDOI, "?format=citation_text").c_str());
-	curl.setOpt(CURLOPT_WRITEFUNCTION, cURL::defaultWriteFunction);
-	curl.setOpt(CURLOPT_WRITEDATA, &data);
+std::unique_ptr<PangaeaAPI::MetaData> PangaeaAPI::getCachedMetaData(const std::string &dataSetDOI) {
+	std::unique_ptr<FileCache> cache = getResponseCache();
+	if(!cache) {
+		return nullptr;
+	}
 
-	try {
-		curl.perform();
-	} catch (const cURLException&) {
-		throw std::runtime_error("PangaeaAPI: could not retrieve citation from pangaea");
+	Json::Value entry;
+	Json::Value json;
+	if(!readCacheEntry(*cache, dataSetDOI, "metadata_jsonld", entry) || !parseMetaData(entry["body"].asString(), json)) {
+		return nullptr;
 	}
 
-	return data.str();
+	return make_unique<MetaData>(json);
+}
+
+std::string PangaeaAPI::getCitation(const std::string &dataSetDOI) {
+	static SingleFlight<std::string, std::string> flights;
+
+	return flights.run(dataSetDOI, [&dataSetDOI]() -> std::string {
+		try {
+			return getFromPangaea(dataSetDOI, "citation_text");
+		} catch (const cURLException&) {
+			throw std::runtime_error("PangaeaAPI: could not retrieve citation from pangaea");
+		}
+	});
 }
 
 
@@ -1,6 +1,9 @@
 #ifndef UTIL_PANGAEAAPI_H_
 #define UTIL_PANGAEAAPI_H_
 
+#include "util/filecache.h"
+
+#include <memory>
 #include <vector>
 #include <json/json.h>
 
@@ -50,24 +53,70 @@ public:
 		std::string spatialCoverageWKT;
 		SpatialCoverageType spatialCoverageType;
 
+		/**
+		 * bounds of the spatial coverage in longitude/latitude, if known
+		 */
+		bool hasSpatialCoverageBounds;
+		double coverageX1, coverageY1, coverageX2, coverageY2;
+
 		std::string license;
 		std::string url;
 
 		void initSpatialCoverage(const Json::Value &json);
 
+		/**
+		 * check if the spatial coverage intersects the given longitude/latitude rectangle.
+		 * This is true if the coverage is unknown.
+		 */
+		bool intersectsSpatialCoverage(double x1, double y1, double x2, double y2) const;
+
         void parseFormat(const Json::Value &json);
     };
 
 	static MetaData getMetaData(const std::string &dataSetDOI);
 
+	/**
+	 * get the metadata of the data set from the local cache without any request to pangaea,
+	 * regardless of its age
+	 * @return the metadata or nullptr if it is not cached
+	 */
+	static std::unique_ptr<MetaData> getCachedMetaData(const std::string &dataSetDOI);
+
 	static std::string getCitation(const std::string &dataSetDOI);
 
+	/**
+	 * @return the members of the JSON-LD metadata that are read by MetaData
+	 */
     static Json::Value getMetaDataFromPangaea(const std::string &dataSetDOI);
 
 private:
 
     static std::vector<Parameter> parseParameters(const Json::Value &json);
 
+	/**
+	 * extract the members of the JSON-LD metadata that are read by MetaData
+	 * @return false if the metadata could not be parsed
+	 */
+	static bool parseMetaData(const std::string &data, Json::Value &json);
+
+	/**
+	 * get a representation of the data set from pangaea in the given format.
+	 * If `pangaea.cache.path` is configured, responses are cached on disk and
+	 * revalidated using ETag/Last-Modified once they are older than `pangaea.cache.ttl` seconds.
+	 */
+	static std::string getFromPangaea(const std::string &dataSetDOI, const std::string &format);
+
+	/**
+	 * @return the cache of Pangaea responses, nullptr if caching is disabled
+	 */
+	static std::unique_ptr<FileCache> getResponseCache();
+
+	/**
+	 * read the cache entry of the data set representation in the given format
+	 * @return false if there is no valid entry
+	 */
+	static bool readCacheEntry(FileCache &cache, const std::string &dataSetDOI, const std::string &format, Json::Value &entry);
+
 
 };
 
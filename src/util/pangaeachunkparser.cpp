@@ -0,0 +1,110 @@
+#include "pangaeachunkparser.h"
+
+#include "util/csv_source_util.h"
+#include "util/exceptions.h"
+#include "util/tabscanner.h"
+
+#include <deque>
+#include <future>
+#include <sstream>
+
+PangaeaChunkParser::PangaeaChunkParser(std::shared_ptr<PangaeaTabParser> tabParser, const Json::Value &csvParameters, const std::string &defaultX,
+									   std::vector<size_t> projection, std::string header)
+		: tabParser(std::move(tabParser)), csvParameters(csvParameters), defaultX(defaultX), projection(std::move(projection)), header(std::move(header)) {
+	separator = CSVSourceUtil(csvParameters).field_separator;
+}
+
+std::unique_ptr<PointCollection> PangaeaChunkParser::parseChunk(std::shared_ptr<std::string> chunk, const QueryRectangle &rect) const {
+	if(tabParser && !PangaeaTabParser::hasQuotes(chunk->data(), chunk->data() + chunk->size())) {
+		auto chunkPoints = tabParser->createCollection(rect);
+		tabParser->parse(chunk->data(), chunk->data() + chunk->size(), *chunkPoints);
+		return chunkPoints->filterBySpatioTemporalReferenceIntersection(rect);
+	}
+
+	std::string csv = header;
+	TabScanner::projectFields(chunk->data(), chunk->data() + chunk->size(), separator, projection, csv);
+	chunk.reset();
+
+	CSVSourceUtil chunkUtil(csvParameters);
+	chunkUtil.default_x = defaultX;
+
+	std::istringstream chunkStream(csv);
+	return chunkUtil.getPointCollection(chunkStream, rect);
+}
+
+std::unique_ptr<PointCollection> PangaeaChunkParser::parse(std::istream &data, const QueryRectangle &rect, ThreadPool &pool, size_t chunkSize, size_t threshold) const {
+	// the tasks keep their own copy of the parser, as they may outlive this call if it fails
+	auto parser = std::make_shared<PangaeaChunkParser>(*this);
+
+	std::deque<std::future<std::unique_ptr<PointCollection>>> pending;
+	std::unique_ptr<PointCollection> points;
+
+	// collect the results in the order of the chunks
+	auto collect = [&pending, &points]() {
+		auto chunkPoints = pending.front().get();
+		pending.pop_front();
+		if(points) {
+			appendPoints(*points, *chunkPoints);
+		} else {
+			points = std::move(chunkPoints);
+		}
+	};
+
+	// chunks end at record boundaries, so records with quoted line breaks are never split
+	bool first = true;
+	auto chunk = std::make_shared<std::string>();
+	while(TabScanner::readChunk(data, first ? threshold : chunkSize, separator, *chunk)) {
+		// small data sets are parsed by the calling thread without waiting for the pool
+		if(first && data.peek() == std::char_traits<char>::eof()) {
+			points = parseChunk(chunk, rect);
+			break;
+		}
+		first = false;
+
+		pending.push_back(pool.submit([parser, chunk, rect]() {
+			return parser->parseChunk(chunk, rect);
+		}));
+		chunk = std::make_shared<std::string>();
+
+		// bound the number of chunks held in memory
+		if(pending.size() > 2 * pool.size()) {
+			collect();
+		}
+	}
+
+	while(!pending.empty()) {
+		collect();
+	}
+
+	return points;
+}
+
+void PangaeaChunkParser::appendPoints(PointCollection &target, PointCollection &source) {
+	auto numericKeys = source.feature_attributes.getNumericKeys();
+	auto textualKeys = source.feature_attributes.getTextualKeys();
+	bool hasTime = source.hasTime();
+
+	// chunks parsed by different parsers must agree, otherwise attributes would be misaligned
+	if(numericKeys != target.feature_attributes.getNumericKeys() || textualKeys != target.feature_attributes.getTextualKeys()
+			|| (hasTime != target.hasTime() && source.getFeatureCount() > 0 && target.getFeatureCount() > 0)) {
+		throw MustNotHappenException("PangaeaChunkParser: the chunks of the data set were parsed with different attributes");
+	}
+
+	for(size_t feature = 0; feature < source.getFeatureCount(); ++feature) {
+		for(size_t i = source.start_feature[feature]; i < source.start_feature[feature + 1]; ++i) {
+			target.addCoordinate(source.coordinates[i].x, source.coordinates[i].y);
+		}
+		size_t index = target.finishFeature();
+
+		for(auto &key : numericKeys) {
+			target.feature_attributes.numeric(key).set(index, source.feature_attributes.numeric(key).get(feature));
+		}
+		for(auto &key : textualKeys) {
+			target.feature_attributes.textual(key).set(index, source.feature_attributes.textual(key).get(feature));
+		}
+
+		if(hasTime) {
+			target.time.push_back(source.time[feature]);
+		}
+	}
+}
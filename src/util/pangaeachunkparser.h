@@ -0,0 +1,61 @@
+#ifndef UTIL_PANGAEACHUNKPARSER_H_
+#define UTIL_PANGAEACHUNKPARSER_H_
+
+#include "datatypes/pointcollection.h"
+#include "util/pangaeatabparser.h"
+#include "util/threadpool.h"
+
+#include <istream>
+#include <json/json.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Parses the points of a Pangaea data set in chunks on a thread pool.
+ *
+ * The data is split at record boundaries into chunks, which are parsed concurrently and
+ * concatenated in order. Chunks without quotes are parsed by the PangaeaTabParser, if one is
+ * given. All other chunks are projected to the requested columns and parsed by CSVSourceUtil,
+ * so the result is the same as parsing the whole data with CSVSourceUtil.
+ */
+class PangaeaChunkParser {
+public:
+	/**
+	 * @param tabParser the fast parser for chunks without quotes, nullptr to parse all chunks with CSVSourceUtil
+	 * @param csvParameters the CSV parameters of the operator
+	 * @param defaultX the geometry of features without coordinates, see CSVSourceUtil::default_x
+	 * @param projection the indices of the columns that are passed to CSVSourceUtil, in file order
+	 * @param header the CSV header of the projected columns, ending with a line break
+	 */
+	PangaeaChunkParser(std::shared_ptr<PangaeaTabParser> tabParser, const Json::Value &csvParameters, const std::string &defaultX,
+					   std::vector<size_t> projection, std::string header);
+
+	/**
+	 * parse the data without header. Data up to threshold bytes is parsed by the calling thread.
+	 * @param chunkSize the size of the chunks that are parsed on the pool
+	 * @return the points, nullptr if there is no data
+	 */
+	std::unique_ptr<PointCollection> parse(std::istream &data, const QueryRectangle &rect, ThreadPool &pool, size_t chunkSize, size_t threshold) const;
+
+	/**
+	 * append all features of the source collection to the target collection.
+	 * Throws if the collections do not have the same attributes.
+	 */
+	static void appendPoints(PointCollection &target, PointCollection &source);
+
+private:
+	/**
+	 * parse the chunk, which is released as soon as it is no longer needed
+	 */
+	std::unique_ptr<PointCollection> parseChunk(std::shared_ptr<std::string> chunk, const QueryRectangle &rect) const;
+
+	std::shared_ptr<PangaeaTabParser> tabParser;
+	Json::Value csvParameters;
+	std::string defaultX;
+	std::vector<size_t> projection;
+	std::string header;
+	char separator;
+};
+
+#endif /* UTIL_PANGAEACHUNKPARSER_H_ */
@@ -0,0 +1,603 @@
+#include "pangaeacolumnstore.h"
+
+#include "util/pangaeatabparser.h"
+#include "util/tabscanner.h"
+#include "util/concat.h"
+#include "util/make_unique.h"
+#include "util/threadpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+/**
+ * File layout, all sections are aligned to 8 bytes:
+ * - header
+ * - column entries
+ * - column names
+ * - column data: doubles for numeric columns, rowCount + 1 offsets followed by the bytes for textual columns
+ * - grid: gridSize * gridSize + 1 start indices followed by the row numbers of all cells
+ */
+struct PangaeaColumnStore::Header {
+	char magic[8];
+	uint64_t rowCount;
+	uint64_t columnCount;
+	uint64_t lonColumn;
+	uint64_t latColumn;
+	uint64_t invalidRows; // rows without valid coordinates, which are not in the grid
+	uint64_t gridSize;
+	uint64_t gridOffset;
+	double minX, minY, maxX, maxY;
+};
+
+struct PangaeaColumnStore::ColumnEntry {
+	uint64_t type;
+	uint64_t nameOffset;
+	uint64_t nameLength;
+	uint64_t dataOffset;
+};
+
+static const char storeMagic[8] = {'P', 'G', 'C', 'O', 'L', 'S', '1', '\0'};
+
+/**
+ * @return the grid cell of the value in [0, gridSize)
+ */
+static size_t gridCell(double value, double min, double max, size_t gridSize) {
+	if(!(max > min)) {
+		return 0;
+	}
+
+	double position = (value - min) / (max - min) * gridSize;
+	if(!(position > 0)) {
+		return 0;
+	}
+	return std::min(static_cast<size_t>(position), gridSize - 1);
+}
+
+static size_t padding(size_t size) {
+	return (8 - size % 8) % 8;
+}
+
+/**
+ * @return the inode of the file, 0 if it does not exist. Replaced entries of the cache get a new
+ *         inode, while the modification time also changes when an entry is read.
+ */
+static ino_t getInode(const std::string &path) {
+	struct stat status;
+	return stat(path.c_str(), &status) == 0 ? status.st_ino : 0;
+}
+
+SingleFlight<std::string, bool> PangaeaColumnStore::builds;
+
+PangaeaColumnStore::PangaeaColumnStore(std::unique_ptr<MappedFile> file)
+		: file(std::move(file)), data(this->file->getData()), size(this->file->getSize()),
+		  header(reinterpret_cast<const Header*>(data)), columns(reinterpret_cast<const ColumnEntry*>(data + sizeof(Header))) {
+}
+
+PangaeaColumnStore::~PangaeaColumnStore() {
+}
+
+std::string PangaeaColumnStore::getCacheKey(const std::string &doi) {
+	return concat(doi, ".cols");
+}
+
+std::unique_ptr<PangaeaColumnStore> PangaeaColumnStore::open(const FileCache &cache, const std::string &doi) {
+	std::string key = getCacheKey(doi);
+
+	// marks the entry as recently used
+	std::ifstream file;
+	if(!cache.open(key, file)) {
+		return nullptr;
+	}
+	file.close();
+
+	std::unique_ptr<MappedFile> mapped = MappedFile::open(cache.getPath(key));
+	if(!mapped) {
+		return nullptr;
+	}
+
+	std::unique_ptr<PangaeaColumnStore> store(new PangaeaColumnStore(std::move(mapped)));
+	if(!store->isValid()) {
+		return nullptr;
+	}
+	return store;
+}
+
+void PangaeaColumnStore::remove(const FileCache &cache, const std::string &doi) {
+	cache.remove(getCacheKey(doi));
+}
+
+bool PangaeaColumnStore::isValid() const {
+	if(size < sizeof(Header) || std::memcmp(header->magic, storeMagic, sizeof(storeMagic)) != 0) {
+		return false;
+	}
+
+	uint64_t rowCount = header->rowCount;
+	if(rowCount > std::numeric_limits<uint32_t>::max() || header->invalidRows > rowCount
+	   || header->columnCount > (size - sizeof(Header)) / sizeof(ColumnEntry)
+	   || header->lonColumn >= header->columnCount || header->latColumn >= header->columnCount) {
+		return false;
+	}
+
+	for(size_t i = 0; i < header->columnCount; ++i) {
+		const ColumnEntry &column = columns[i];
+		if(column.nameOffset > size || column.nameLength > size - column.nameOffset || column.dataOffset > size) {
+			return false;
+		}
+
+		uint64_t available = size - column.dataOffset;
+		if(column.type == NUMERIC) {
+			if(rowCount * sizeof(double) > available) {
+				return false;
+			}
+		} else if(column.type == TEXTUAL) {
+			uint64_t offsetsSize = (rowCount + 1) * sizeof(uint64_t);
+			if(offsetsSize > available
+			   || reinterpret_cast<const uint64_t*>(data + column.dataOffset)[rowCount] > available - offsetsSize) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+
+	if(columns[header->lonColumn].type != NUMERIC || columns[header->latColumn].type != NUMERIC) {
+		return false;
+	}
+
+	uint64_t cells = header->gridSize * header->gridSize;
+	if(header->gridSize == 0 || header->gridSize > 1024 || header->gridOffset > size
+	   || (cells + 1) * sizeof(uint64_t) > size - header->gridOffset) {
+		return false;
+	}
+	uint64_t indexedRows = reinterpret_cast<const uint64_t*>(data + header->gridOffset)[cells];
+	return indexedRows == rowCount - header->invalidRows
+		   && indexedRows * sizeof(uint32_t) <= size - header->gridOffset - (cells + 1) * sizeof(uint64_t);
+}
+
+const PangaeaColumnStore::ColumnEntry *PangaeaColumnStore::findColumn(const std::string &name) const {
+	for(size_t i = 0; i < header->columnCount; ++i) {
+		const ColumnEntry &column = columns[i];
+		if(column.nameLength == name.size() && std::memcmp(data + column.nameOffset, name.data(), name.size()) == 0) {
+			return &column;
+		}
+	}
+	return nullptr;
+}
+
+const double *PangaeaColumnStore::numericValues(const ColumnEntry &column) const {
+	return reinterpret_cast<const double*>(data + column.dataOffset);
+}
+
+std::string PangaeaColumnStore::textualValue(const ColumnEntry &column, size_t row) const {
+	const uint64_t *offsets = reinterpret_cast<const uint64_t*>(data + column.dataOffset);
+	const char *bytes = data + column.dataOffset + (header->rowCount + 1) * sizeof(uint64_t);
+	return std::string(bytes + offsets[row], bytes + offsets[row + 1]);
+}
+
+std::vector<uint32_t> PangaeaColumnStore::findRows(double x1, double y1, double x2, double y2) const {
+	std::vector<uint32_t> rows;
+	if(header->rowCount == header->invalidRows
+	   || x2 < header->minX || x1 > header->maxX || y2 < header->minY || y1 > header->maxY) {
+		return rows;
+	}
+
+	size_t gridSize = header->gridSize;
+	size_t cellX1 = gridCell(std::max(x1, header->minX), header->minX, header->maxX, gridSize);
+	size_t cellX2 = gridCell(std::min(x2, header->maxX), header->minX, header->maxX, gridSize);
+	size_t cellY1 = gridCell(std::max(y1, header->minY), header->minY, header->maxY, gridSize);
+	size_t cellY2 = gridCell(std::min(y2, header->maxY), header->minY, header->maxY, gridSize);
+
+	const uint64_t *cellStart = reinterpret_cast<const uint64_t*>(data + header->gridOffset);
+	const uint32_t *cellRows = reinterpret_cast<const uint32_t*>(cellStart + gridSize * gridSize + 1);
+
+	for(size_t cellY = cellY1; cellY <= cellY2; ++cellY) {
+		for(size_t cellX = cellX1; cellX <= cellX2; ++cellX) {
+			size_t cell = cellY * gridSize + cellX;
+			rows.insert(rows.end(), cellRows + cellStart[cell], cellRows + cellStart[cell + 1]);
+		}
+	}
+
+	// keep the order of the data set
+	std::sort(rows.begin(), rows.end());
+
+	return rows;
+}
+
+std::unique_ptr<PointCollection> PangaeaColumnStore::getPoints(const Json::Value &params, const QueryRectangle &rect) const {
+	if(!PangaeaTabParser::isApplicable(params) || rect.crsId != CrsId::wgs84()) {
+		return nullptr;
+	}
+
+	// invalid coordinates have to be reported by the text parser
+	if(params.get("on_error", "skip").asString() == "abort" && header->invalidRows > 0) {
+		return nullptr;
+	}
+
+	const Json::Value &columnParams = params["columns"];
+	const ColumnEntry *columnX = findColumn(columnParams.get("x", "").asString());
+	const ColumnEntry *columnY = findColumn(columnParams.get("y", "").asString());
+	const ColumnEntry *lon = &columns[header->lonColumn];
+	const ColumnEntry *lat = &columns[header->latColumn];
+
+	bool lonLat = columnX == lon && columnY == lat;
+	bool latLon = columnX == lat && columnY == lon;
+	if(!lonLat && !latLon) {
+		return nullptr;
+	}
+
+	std::vector<std::pair<std::string, const ColumnEntry*>> numericColumns;
+	for(auto &name : columnParams.get("numeric", Json::Value(Json::arrayValue))) {
+		const ColumnEntry *column = findColumn(name.asString());
+		if(column == nullptr || column->type != NUMERIC) {
+			return nullptr;
+		}
+		numericColumns.emplace_back(name.asString(), column);
+	}
+
+	std::vector<std::pair<std::string, const ColumnEntry*>> textualColumns;
+	for(auto &name : columnParams.get("textual", Json::Value(Json::arrayValue))) {
+		const ColumnEntry *column = findColumn(name.asString());
+		if(column == nullptr || column->type != TEXTUAL) {
+			return nullptr;
+		}
+		textualColumns.emplace_back(name.asString(), column);
+	}
+
+	std::vector<uint32_t> rows = lonLat ? findRows(rect.x1, rect.y1, rect.x2, rect.y2)
+										: findRows(rect.y1, rect.x1, rect.y2, rect.x2);
+
+	auto points = make_unique<PointCollection>(rect);
+	for(auto &column : numericColumns) {
+		points->feature_attributes.addNumericAttribute(column.first, Unit::unknown());
+	}
+	for(auto &column : textualColumns) {
+		points->feature_attributes.addTextualAttribute(column.first, Unit::unknown());
+	}
+
+	std::vector<decltype(&points->feature_attributes.numeric(std::string()))> numericArrays;
+	for(auto &column : numericColumns) {
+		numericArrays.push_back(&points->feature_attributes.numeric(column.first));
+	}
+	std::vector<decltype(&points->feature_attributes.textual(std::string()))> textualArrays;
+	for(auto &column : textualColumns) {
+		textualArrays.push_back(&points->feature_attributes.textual(column.first));
+	}
+
+	const double *xs = numericValues(*columnX);
+	const double *ys = numericValues(*columnY);
+	for(uint32_t row : rows) {
+		points->addSinglePointFeature(Coordinate(xs[row], ys[row]));
+		size_t feature = points->getFeatureCount() - 1;
+
+		for(size_t i = 0; i < numericColumns.size(); ++i) {
+			numericArrays[i]->set(feature, numericValues(*numericColumns[i].second)[row]);
+		}
+		for(size_t i = 0; i < textualColumns.size(); ++i) {
+			textualArrays[i]->set(feature, textualValue(*textualColumns[i].second, row));
+		}
+	}
+
+	return points->filterBySpatioTemporalReferenceIntersection(rect);
+}
+
+/**
+ * the maximum size of the column data that is held in memory while converting a data set
+ */
+static const uint64_t maxBufferedColumnBytes = 64 * 1024 * 1024;
+
+typedef std::vector<std::pair<const char*, const char*>> Fields;
+
+/**
+ * split the line at position into at most maxFields fields
+ * @return the start of the next line
+ */
+static const char *readFields(const char *position, const char *end, size_t maxFields, Fields &fields) {
+	fields.clear();
+
+	const char *lineEnd = nullptr;
+	while(fields.size() < maxFields) {
+		const char *fieldEnd = TabScanner::findDelimiter(position, end, '\t');
+		fields.emplace_back(position, fieldEnd);
+
+		if(fieldEnd == end || *fieldEnd == '\n') {
+			lineEnd = fieldEnd;
+			// handle windows line breaks
+			if(fields.back().second > fields.back().first && *(fields.back().second - 1) == '\r') {
+				--fields.back().second;
+			}
+			break;
+		}
+		position = fieldEnd + 1;
+	}
+	if(lineEnd == nullptr) {
+		lineEnd = TabScanner::findLineEnd(position, end);
+	}
+
+	return lineEnd == end ? end : lineEnd + 1;
+}
+
+static bool isEmptyLine(const Fields &fields) {
+	return fields.size() == 1 && fields[0].first == fields[0].second;
+}
+
+static double parseNumber(const Fields &fields, size_t column) {
+	double value = NAN;
+	if(column < fields.size() && !TabScanner::parseDouble(fields[column].first, fields[column].second, value)) {
+		value = NAN;
+	}
+	return value;
+}
+
+/**
+ * single low priority thread for the conversions, so they neither occupy the parser threads of
+ * the queries nor compete with them for the CPU
+ */
+static ThreadPool &getBuildPool() {
+	static ThreadPool pool(1);
+	return pool;
+}
+
+void PangaeaColumnStore::buildInBackground(std::shared_ptr<const FileCache> cache, const std::string &doi, const std::vector<PangaeaAPI::Parameter> &parameters) {
+	getBuildPool().submit([cache, doi, parameters]() {
+		static thread_local bool lowered = setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19) == 0;
+		(void) lowered;
+
+		build(*cache, doi, parameters);
+	});
+}
+
+void PangaeaColumnStore::build(const FileCache &cache, const std::string &doi, const std::vector<PangaeaAPI::Parameter> &parameters) {
+	std::string key = getCacheKey(doi);
+
+	// only one conversion per data set, others do not wait for it
+	std::shared_future<bool> flight;
+	auto lease = builds.join(key, flight);
+	if(!lease) {
+		return;
+	}
+
+	std::ifstream existing;
+	if(cache.open(key, existing)) {
+		lease->complete(true);
+		return;
+	}
+
+	auto isLon = [](const PangaeaAPI::Parameter &parameter) { return parameter.isLongitudeColumn(); };
+	auto isLat = [](const PangaeaAPI::Parameter &parameter) { return parameter.isLatitudeColumn(); };
+	size_t lonColumn = static_cast<size_t>(std::find_if(parameters.begin(), parameters.end(), isLon) - parameters.begin());
+	size_t latColumn = static_cast<size_t>(std::find_if(parameters.begin(), parameters.end(), isLat) - parameters.begin());
+	if(lonColumn == parameters.size() || latColumn == parameters.size()) {
+		lease->complete(false);
+		return;
+	}
+
+	std::string sourceKey = concat(doi, ".tab");
+	std::ifstream sourceFile;
+	if(!cache.open(sourceKey, sourceFile)) {
+		lease->complete(false);
+		return;
+	}
+	sourceFile.close();
+
+	// the data file may be replaced while converting, when revalidation finds an update
+	std::string sourcePath = cache.getPath(sourceKey);
+	ino_t sourceInode = getInode(sourcePath);
+	std::unique_ptr<MappedFile> sourceMapping = MappedFile::open(sourcePath);
+	if(!sourceMapping || getInode(sourcePath) != sourceInode) {
+		lease->complete(false);
+		return;
+	}
+	const char *source = sourceMapping->getData();
+	size_t sourceSize = sourceMapping->getSize();
+
+	const char *dataBegin = source;
+	const char *end = source + sourceSize;
+
+	// skip the data description and the header line
+	if(sourceSize >= 2 && source[0] == '/' && source[1] == '*') {
+		const char *descriptionEnd = std::search(dataBegin, end, "*/\n", "*/\n" + 3);
+		dataBegin = descriptionEnd == end ? end : descriptionEnd + 3;
+	}
+	dataBegin = std::min(TabScanner::findLineEnd(dataBegin, end) + 1, end);
+
+	// quoted fields are only handled by the generic CSV parser
+	if(PangaeaTabParser::hasQuotes(dataBegin, end)) {
+		lease->complete(false);
+		return;
+	}
+
+	size_t columnCount = parameters.size();
+	std::vector<bool> isNumeric(columnCount);
+	for(size_t column = 0; column < columnCount; ++column) {
+		// coordinates are always stored as numbers
+		isNumeric[column] = parameters[column].numeric || column == lonColumn || column == latColumn;
+	}
+
+	// first pass: the number of rows, the sizes of the textual columns and the coordinates for the grid
+	std::vector<double> lons;
+	std::vector<double> lats;
+	std::vector<uint64_t> textualSizes(columnCount, 0);
+	uint64_t rowCount = 0;
+
+	Fields fields;
+	for(const char *position = dataBegin; position < end;) {
+		position = readFields(position, end, columnCount, fields);
+		if(isEmptyLine(fields)) {
+			continue;
+		}
+
+		if(rowCount == std::numeric_limits<uint32_t>::max()) {
+			lease->complete(false);
+			return;
+		}
+		++rowCount;
+
+		lons.push_back(parseNumber(fields, lonColumn));
+		lats.push_back(parseNumber(fields, latColumn));
+		for(size_t column = 0; column < fields.size(); ++column) {
+			if(!isNumeric[column]) {
+				textualSizes[column] += static_cast<uint64_t>(fields[column].second - fields[column].first);
+			}
+		}
+	}
+
+	// grid over the extent of all valid coordinates
+	Header header;
+	std::memcpy(header.magic, storeMagic, sizeof(storeMagic));
+	header.rowCount = rowCount;
+	header.columnCount = columnCount;
+	header.lonColumn = lonColumn;
+	header.latColumn = latColumn;
+	header.minX = header.minY = std::numeric_limits<double>::max();
+	header.maxX = header.maxY = std::numeric_limits<double>::lowest();
+
+	uint64_t validRows = 0;
+	for(size_t row = 0; row < rowCount; ++row) {
+		if(std::isfinite(lons[row]) && std::isfinite(lats[row])) {
+			++validRows;
+			header.minX = std::min(header.minX, lons[row]);
+			header.maxX = std::max(header.maxX, lons[row]);
+			header.minY = std::min(header.minY, lats[row]);
+			header.maxY = std::max(header.maxY, lats[row]);
+		}
+	}
+	header.invalidRows = rowCount - validRows;
+	header.gridSize = std::max<uint64_t>(1, std::min<uint64_t>(1024, static_cast<uint64_t>(std::sqrt(validRows / 64.0))));
+
+	size_t gridSize = header.gridSize;
+	std::vector<uint64_t> cellStart(gridSize * gridSize + 1, 0);
+	std::vector<uint32_t> cellRows(validRows);
+	std::vector<uint32_t> rowCells(rowCount);
+	for(size_t row = 0; row < rowCount; ++row) {
+		if(std::isfinite(lons[row]) && std::isfinite(lats[row])) {
+			rowCells[row] = static_cast<uint32_t>(gridCell(lats[row], header.minY, header.maxY, gridSize) * gridSize
+												  + gridCell(lons[row], header.minX, header.maxX, gridSize));
+			++cellStart[rowCells[row] + 1];
+		}
+	}
+	for(size_t cell = 0; cell < gridSize * gridSize; ++cell) {
+		cellStart[cell + 1] += cellStart[cell];
+	}
+	std::vector<uint64_t> cellFill(cellStart.begin(), cellStart.end() - 1);
+	for(size_t row = 0; row < rowCount; ++row) {
+		if(std::isfinite(lons[row]) && std::isfinite(lats[row])) {
+			cellRows[cellFill[rowCells[row]]++] = static_cast<uint32_t>(row);
+		}
+	}
+	std::vector<double>().swap(lons);
+	std::vector<double>().swap(lats);
+	std::vector<uint32_t>().swap(rowCells);
+	std::vector<uint64_t>().swap(cellFill);
+
+	// compute the layout
+	auto columnBytes = [&isNumeric, &textualSizes, rowCount](size_t column) -> uint64_t {
+		return isNumeric[column] ? rowCount * sizeof(double) : (rowCount + 1) * sizeof(uint64_t) + textualSizes[column];
+	};
+
+	std::vector<ColumnEntry> entries(columnCount);
+	uint64_t offset = sizeof(Header) + columnCount * sizeof(ColumnEntry);
+	for(size_t column = 0; column < columnCount; ++column) {
+		entries[column].type = isNumeric[column] ? NUMERIC : TEXTUAL;
+		entries[column].nameOffset = offset;
+		entries[column].nameLength = parameters[column].name.size();
+		offset += parameters[column].name.size();
+	}
+	offset += padding(offset);
+	for(size_t column = 0; column < columnCount; ++column) {
+		entries[column].dataOffset = offset;
+		offset += columnBytes(column);
+		offset += padding(offset);
+	}
+	header.gridOffset = offset;
+
+	static const char zeros[8] = {0};
+	auto writer = cache.createWriter(key);
+	writer->write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	writer->write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ColumnEntry));
+	size_t namesSize = 0;
+	for(auto &parameter : parameters) {
+		writer->write(parameter.name.data(), parameter.name.size());
+		namesSize += parameter.name.size();
+	}
+	writer->write(zeros, padding(sizeof(Header) + columnCount * sizeof(ColumnEntry) + namesSize));
+
+	// the columns are converted in groups that fit into the buffer, with one pass over the data per group
+	for(size_t groupBegin = 0, groupEnd = 0; groupBegin < columnCount; groupBegin = groupEnd) {
+		uint64_t groupBytes = columnBytes(groupBegin);
+		for(groupEnd = groupBegin + 1; groupEnd < columnCount && groupBytes + columnBytes(groupEnd) <= maxBufferedColumnBytes; ++groupEnd) {
+			groupBytes += columnBytes(groupEnd);
+		}
+
+		size_t groupSize = groupEnd - groupBegin;
+		std::vector<std::vector<double>> numericData(groupSize);
+		std::vector<std::string> textualData(groupSize);
+		std::vector<std::vector<uint64_t>> textualOffsets(groupSize);
+		for(size_t i = 0; i < groupSize; ++i) {
+			if(isNumeric[groupBegin + i]) {
+				numericData[i].reserve(rowCount);
+			} else {
+				textualData[i].reserve(textualSizes[groupBegin + i]);
+				textualOffsets[i].reserve(rowCount + 1);
+				textualOffsets[i].push_back(0);
+			}
+		}
+
+		for(const char *position = dataBegin; position < end;) {
+			position = readFields(position, end, groupEnd, fields);
+			if(isEmptyLine(fields)) {
+				continue;
+			}
+
+			for(size_t i = 0; i < groupSize; ++i) {
+				size_t column = groupBegin + i;
+				if(isNumeric[column]) {
+					numericData[i].push_back(parseNumber(fields, column));
+				} else {
+					if(column < fields.size()) {
+						textualData[i].append(fields[column].first, fields[column].second);
+					}
+					textualOffsets[i].push_back(textualData[i].size());
+				}
+			}
+		}
+
+		for(size_t i = 0; i < groupSize; ++i) {
+			if(isNumeric[groupBegin + i]) {
+				writer->write(reinterpret_cast<const char*>(numericData[i].data()), rowCount * sizeof(double));
+			} else {
+				if(textualData[i].size() != textualSizes[groupBegin + i]) {
+					// the uncommitted entry is discarded
+					lease->complete(false);
+					return;
+				}
+				writer->write(reinterpret_cast<const char*>(textualOffsets[i].data()), (rowCount + 1) * sizeof(uint64_t));
+				writer->write(textualData[i].data(), textualData[i].size());
+				writer->write(zeros, padding(textualData[i].size()));
+			}
+		}
+	}
+	writer->write(reinterpret_cast<const char*>(cellStart.data()), cellStart.size() * sizeof(uint64_t));
+	writer->write(reinterpret_cast<const char*>(cellRows.data()), cellRows.size() * sizeof(uint32_t));
+
+	// a store of an outdated data file must not replace the removed one
+	if(getInode(sourcePath) != sourceInode) {
+		lease->complete(false);
+		return;
+	}
+	writer->commit();
+	if(getInode(sourcePath) != sourceInode) {
+		remove(cache, doi);
+		lease->complete(false);
+		return;
+	}
+
+	lease->complete(true);
+}
@@ -0,0 +1,98 @@
+#ifndef UTIL_PANGAEACOLUMNSTORE_H_
+#define UTIL_PANGAEACOLUMNSTORE_H_
+
+#include "datatypes/pointcollection.h"
+#include "util/filecache.h"
+#include "util/mappedfile.h"
+#include "util/pangaeaapi.h"
+#include "util/singleflight.h"
+
+#include <json/json.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Binary columnar representation of a downloaded Pangaea data set, stored next to
+ * the tab separated file in the data cache.
+ *
+ * Numeric parameters are stored as arrays of doubles, all other parameters as string
+ * offsets and bytes. A regular grid over the longitude/latitude columns lists the rows
+ * of every cell, so a query only touches the rows and columns it needs. The file is
+ * memory mapped for reading.
+ */
+class PangaeaColumnStore {
+public:
+	~PangaeaColumnStore();
+
+	PangaeaColumnStore(const PangaeaColumnStore&) = delete;
+	PangaeaColumnStore &operator=(const PangaeaColumnStore&) = delete;
+
+	/**
+	 * open the columnar representation of the data set
+	 * @return the store or nullptr if it does not exist or is invalid
+	 */
+	static std::unique_ptr<PangaeaColumnStore> open(const FileCache &cache, const std::string &doi);
+
+	/**
+	 * convert the cached tab separated file of the data set. Nothing is done if the
+	 * file is not cached, the data set has no longitude/latitude columns, or the
+	 * conversion is already running. The columns are converted in groups of bounded
+	 * size, so the memory needed does not grow with the number of columns. The result is
+	 * discarded if the data file is replaced meanwhile.
+	 */
+	static void build(const FileCache &cache, const std::string &doi, const std::vector<PangaeaAPI::Parameter> &parameters);
+
+	/**
+	 * run build on a background thread with low priority
+	 */
+	static void buildInBackground(std::shared_ptr<const FileCache> cache, const std::string &doi, const std::vector<PangaeaAPI::Parameter> &parameters);
+
+	/**
+	 * remove the columnar representation of the data set, e.g. because the data set was updated
+	 */
+	static void remove(const FileCache &cache, const std::string &doi);
+
+	/**
+	 * get the points for the CSV parameters of a query, in the order of the data set
+	 * @return the points or nullptr if the query cannot be answered from the store
+	 */
+	std::unique_ptr<PointCollection> getPoints(const Json::Value &params, const QueryRectangle &rect) const;
+
+private:
+	explicit PangaeaColumnStore(std::unique_ptr<MappedFile> file);
+
+	struct Header;
+	struct ColumnEntry;
+
+	enum ColumnType : uint64_t {
+		NUMERIC = 1, TEXTUAL = 2
+	};
+
+	static std::string getCacheKey(const std::string &doi);
+
+	bool isValid() const;
+
+	const ColumnEntry *findColumn(const std::string &name) const;
+	const double *numericValues(const ColumnEntry &column) const;
+	std::string textualValue(const ColumnEntry &column, size_t row) const;
+
+	/**
+	 * @return the rows that may lie inside the longitude/latitude rectangle, in ascending order
+	 */
+	std::vector<uint32_t> findRows(double x1, double y1, double x2, double y2) const;
+
+	/**
+	 * running conversions by cache key
+	 */
+	static SingleFlight<std::string, bool> builds;
+
+	std::unique_ptr<MappedFile> file;
+	const char *data;
+	size_t size;
+	const Header *header;
+	const ColumnEntry *columns;
+};
+
+#endif /* UTIL_PANGAEACOLUMNSTORE_H_ */
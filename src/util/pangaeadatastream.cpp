@@ -0,0 +1,287 @@
+#include "pangaeadatastream.h"
+
+#include "util/configuration.h"
+#include "util/concat.h"
+#include "util/make_unique.h"
+#include "util/curl.h"
+#include "util/pangaeacolumnstore.h"
+
+#include <json/json.h>
+#include <cstring>
+#include <ctime>
+
+/**
+ * @return true if the download of the flight was cached successfully
+ */
+static bool waitForFlight(const std::shared_future<bool> &flight) {
+	try {
+		return flight.get();
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+PangaeaDataStream::PangaeaDataStream(const std::string &doi, std::function<std::string()> header, size_t maxLines, size_t maxBytes) : std::istream(nullptr) {
+	std::string cacheKey = concat(doi, ".tab");
+	std::streambuf *source;
+
+	cache = getDataCache();
+	if(cache) {
+		revalidate(*cache, doi);
+	}
+
+	// a limited stream does not download the whole file, so it does not take part in caching it
+	bool limited = maxLines > 0 || maxBytes > 0;
+
+	std::shared_ptr<SingleFlight<std::string, bool>::Lease> lease;
+	if(cache && !cache->open(cacheKey, cachedFile) && !limited) {
+		// concurrent requests for the same data set wait for the running download to be cached
+		std::shared_future<bool> flight;
+		lease = downloads.join(cacheKey, flight);
+		if(!lease && waitForFlight(flight)) {
+			cache->open(cacheKey, cachedFile);
+		}
+	}
+
+	if(cachedFile.is_open()) {
+		source = cachedFile.rdbuf();
+	} else {
+		std::function<void(bool, const HttpClient::Response&)> onFinished;
+		if(cache && !limited) {
+			// the download is joined before the cache is destroyed
+			const FileCache *dataCache = cache.get();
+			onFinished = [lease, dataCache, doi](bool success, const HttpClient::Response &response) {
+				if(success) {
+					storeValidators(*dataCache, doi, response);
+				}
+				if(lease) {
+					lease->complete(success);
+				}
+			};
+		}
+
+		download = make_unique<CurlStreamBuffer>(getUrl(doi), cache && !limited ? cache->createWriter(cacheKey) : nullptr, onFinished);
+		source = download.get();
+	}
+
+	filter = make_unique<FilterBuffer>(source, header, maxLines, maxBytes);
+	rdbuf(filter.get());
+}
+
+SingleFlight<std::string, bool> PangaeaDataStream::downloads;
+
+std::string PangaeaDataStream::getUrl(const std::string &doi) {
+	return concat("https://doi.pangaea.de/", doi, "?format=textfile");
+}
+
+std::string PangaeaDataStream::getValidatorsKey(const std::string &doi) {
+	return concat(doi, ".tab.validators");
+}
+
+void PangaeaDataStream::storeValidators(const FileCache &cache, const std::string &doi, const HttpClient::Response &response) {
+	Json::Value validators(Json::objectValue);
+	validators["etag"] = response.getHeader("ETag");
+	validators["lastModified"] = response.getHeader("Last-Modified");
+	validators["fetched"] = static_cast<Json::Int64>(time(nullptr));
+
+	try {
+		Json::FastWriter writer;
+		cache.put(getValidatorsKey(doi), writer.write(validators));
+	} catch (const std::exception&) {
+		// without validators the file is revalidated on the next access
+	}
+}
+
+void PangaeaDataStream::revalidate(const FileCache &cache, const std::string &doi) {
+	std::string validatorsKey = getValidatorsKey(doi);
+	std::string dataKey = concat(doi, ".tab");
+
+	Json::Value validators(Json::objectValue);
+	std::string json;
+	Json::Reader reader;
+	if(!cache.get(validatorsKey, json) || !reader.parse(json, validators) || !validators.isObject()) {
+		validators = Json::Value(Json::objectValue);
+	}
+
+	time_t ttl = Configuration::get<int>("pangaea.cache.ttl", 86400);
+	if(time(nullptr) - validators.get("fetched", 0).asInt64() < ttl) {
+		return;
+	}
+
+	std::ifstream cachedFile;
+	if(!cache.open(dataKey, cachedFile)) {
+		return;
+	}
+	cachedFile.close();
+
+	std::string etag = validators.get("etag", "").asString();
+	std::string lastModified = validators.get("lastModified", "").asString();
+
+	HttpClient::Request request(getUrl(doi));
+	request.head = true;
+	if(!etag.empty()) {
+		request.headers.push_back(concat("If-None-Match: ", etag));
+	}
+	if(!lastModified.empty()) {
+		request.headers.push_back(concat("If-Modified-Since: ", lastModified));
+	}
+
+	HttpClient::Response response;
+	try {
+		response = HttpClient::perform(request);
+	} catch (const cURLException&) {
+		// serve the stale file while pangaea is unreachable
+		return;
+	}
+
+	if(response.status != 200 && response.status != 304) {
+		return;
+	}
+
+	// servers that ignore the conditional request still return the same validators
+	bool unchanged = response.status == 304
+			|| (!etag.empty() && response.getHeader("ETag") == etag)
+			|| (etag.empty() && !lastModified.empty() && response.getHeader("Last-Modified") == lastModified);
+
+	if(unchanged) {
+		validators["fetched"] = static_cast<Json::Int64>(time(nullptr));
+		Json::FastWriter writer;
+		cache.put(validatorsKey, writer.write(validators));
+	} else {
+		cache.remove(dataKey);
+		cache.remove(validatorsKey);
+		PangaeaColumnStore::remove(cache, doi);
+	}
+}
+
+std::unique_ptr<FileCache> PangaeaDataStream::getDataCache() {
+	// data files are cached in a size bounded LRU cache, shared by all workers of the node
+	std::string cachePath = Configuration::get<std::string>("pangaea.cache.path", "");
+	if(cachePath.empty()) {
+		return nullptr;
+	}
+
+	size_t maxSize = static_cast<size_t>(Configuration::get<int>("pangaea.cache.datasize", 1024)) * 1024 * 1024;
+	return make_unique<FileCache>(cachePath + "/data", maxSize);
+}
+
+PangaeaDataStream::~PangaeaDataStream() {
+	rdbuf(nullptr);
+}
+
+void PangaeaDataStream::rethrowIfFailed() {
+	if(download) {
+		download->rethrowIfFailed();
+	}
+}
+
+bool PangaeaDataStream::isTruncated() const {
+	return filter->isTruncated();
+}
+
+PangaeaDataStream::FilterBuffer::FilterBuffer(std::streambuf *source, std::function<std::string()> header, size_t maxLines, size_t maxBytes)
+		: source(source), headerProvider(header), state(State::HEADER), maxLines(maxLines), maxBytes(maxBytes),
+		  lines(0), bytes(0), finished(false), truncated(false) {
+	setg(nullptr, nullptr, nullptr);
+}
+
+bool PangaeaDataStream::FilterBuffer::isTruncated() const {
+	return truncated;
+}
+
+void PangaeaDataStream::FilterBuffer::applyLimits() {
+	size_t end = buffer.size();
+	bool reached = false;
+
+	if(maxBytes > 0 && bytes + end >= maxBytes) {
+		// keep complete lines only
+		end = maxBytes - bytes;
+		size_t lastLineEnd = end > 0 ? buffer.rfind('\n', end - 1) : std::string::npos;
+		end = lastLineEnd == std::string::npos ? 0 : lastLineEnd + 1;
+		reached = true;
+	}
+
+	if(maxLines > 0) {
+		size_t position = 0;
+		while(lines < maxLines) {
+			const void *lineEnd = std::memchr(buffer.data() + position, '\n', end - position);
+			if(lineEnd == nullptr) {
+				break;
+			}
+			position = static_cast<size_t>(static_cast<const char*>(lineEnd) - buffer.data()) + 1;
+			++lines;
+		}
+		if(lines == maxLines) {
+			end = position;
+			reached = true;
+		}
+	}
+
+	if(reached) {
+		finished = true;
+		truncated = end < buffer.size() || source->sgetc() != traits_type::eof();
+	}
+
+	buffer.resize(end);
+	bytes += end;
+}
+
+void PangaeaDataStream::FilterBuffer::skipDescription() {
+	const int_type eof = traits_type::eof();
+	int_type c = source->sgetc();
+
+	// skip the initial comment block, terminated by "*/\n"
+	if(c == '/') {
+		const char *end = "*/\n";
+		size_t matched = 0;
+		while(matched < 3) {
+			c = source->sbumpc();
+			if(c == eof) {
+				return;
+			}
+
+			if(c == end[matched]) {
+				++matched;
+			} else {
+				matched = (c == '*') ? 1 : 0;
+			}
+		}
+	}
+
+	// skip header column
+	// TODO handle \n in column headers
+	do {
+		c = source->sbumpc();
+	} while(c != eof && c != '\n');
+}
+
+PangaeaDataStream::FilterBuffer::int_type PangaeaDataStream::FilterBuffer::underflow() {
+	if(gptr() < egptr()) {
+		return traits_type::to_int_type(*gptr());
+	}
+
+	buffer.clear();
+	if(state == State::HEADER) {
+		state = State::DATA;
+		buffer = headerProvider();
+		skipDescription();
+	}
+
+	if(buffer.empty() && !finished) {
+		buffer.resize(64 * 1024);
+		buffer.resize(static_cast<size_t>(source->sgetn(&buffer[0], buffer.size())));
+
+		if(maxLines > 0 || maxBytes > 0) {
+			applyLimits();
+		}
+	}
+
+	if(buffer.empty()) {
+		return traits_type::eof();
+	}
+
+	char *begin = &buffer[0];
+	setg(begin, begin, begin + buffer.size());
+
+	return traits_type::to_int_type(*gptr());
+}
@@ -0,0 +1,116 @@
+#ifndef UTIL_PANGAEADATASTREAM_H_
+#define UTIL_PANGAEADATASTREAM_H_
+
+#include "util/filecache.h"
+#include "util/curlstreambuffer.h"
+#include "util/singleflight.h"
+
+#include <istream>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * Input stream of the tab separated data of a Pangaea data set, ready to be
+ * consumed by the CSV parser.
+ *
+ * The data is read from the local data cache or streamed from Pangaea while
+ * it is downloaded. The leading data description and the original column
+ * header are skipped on the fly and replaced by the given header.
+ *
+ * The stream can be limited to a prefix of the data, e.g. for previews. A limited
+ * stream stops the download early and never stores the partial data in the cache.
+ *
+ * Cached data files are revalidated using ETag/Last-Modified once they are older than
+ * the configured time to live, and downloaded again if the data set was updated.
+ */
+class PangaeaDataStream : public std::istream {
+public:
+	/**
+	 * @param doi the DOI of the data set
+	 * @param header provides the header line. It is called when the header is first read,
+	 *        so it may wait for data that is fetched concurrently.
+	 * @param maxLines the maximum number of data lines, 0 for no limit
+	 * @param maxBytes the maximum number of data bytes, only complete lines are returned. 0 for no limit
+	 */
+	PangaeaDataStream(const std::string &doi, std::function<std::string()> header, size_t maxLines = 0, size_t maxBytes = 0);
+	virtual ~PangaeaDataStream();
+
+	/**
+	 * throws if the download of the data failed
+	 */
+	void rethrowIfFailed();
+
+	/**
+	 * @return the cache of downloaded data files, nullptr if caching is disabled
+	 */
+	static std::unique_ptr<FileCache> getDataCache();
+
+	/**
+	 * revalidate the cached data file of the data set if it is outdated. If the data set was
+	 * updated, the file and its columnar representation are removed from the cache.
+	 * The stale file is kept if Pangaea cannot be reached.
+	 */
+	static void revalidate(const FileCache &cache, const std::string &doi);
+
+	/**
+	 * @return true if data was left out because of the limits
+	 */
+	bool isTruncated() const;
+
+private:
+	class FilterBuffer : public std::streambuf {
+	public:
+		FilterBuffer(std::streambuf *source, std::function<std::string()> header, size_t maxLines, size_t maxBytes);
+
+		bool isTruncated() const;
+
+	protected:
+		virtual int_type underflow();
+
+	private:
+		void skipDescription();
+
+		/**
+		 * cut the buffer once the line or byte limit is reached
+		 */
+		void applyLimits();
+
+		enum class State {
+			HEADER, DATA
+		};
+
+		std::streambuf *source;
+		std::function<std::string()> headerProvider;
+		State state;
+		std::string buffer;
+
+		size_t maxLines;
+		size_t maxBytes;
+		size_t lines;
+		size_t bytes;
+		bool finished;
+		bool truncated;
+	};
+
+	/**
+	 * running downloads by cache key, the result tells whether the data was cached
+	 */
+	static SingleFlight<std::string, bool> downloads;
+
+	static std::string getUrl(const std::string &doi);
+	static std::string getValidatorsKey(const std::string &doi);
+
+	/**
+	 * store the validators of the downloaded data file
+	 */
+	static void storeValidators(const FileCache &cache, const std::string &doi, const HttpClient::Response &response);
+
+	std::unique_ptr<FileCache> cache;
+	std::ifstream cachedFile;
+	std::unique_ptr<CurlStreamBuffer> download;
+	std::unique_ptr<FilterBuffer> filter;
+};
+
+#endif /* UTIL_PANGAEADATASTREAM_H_ */
@@ -0,0 +1,151 @@
+#include "pangaeatabparser.h"
+
+#include "util/tabscanner.h"
+#include "util/exceptions.h"
+#include "util/make_unique.h"
+#include "util/concat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+bool PangaeaTabParser::isApplicable(const Json::Value &params) {
+	const Json::Value &columns = params["columns"];
+
+	return params.get("geometry", "").asString() == "xy"
+		   && params.get("time", "none").asString() == "none"
+		   && params.get("separator", "").asString() == "\t"
+		   && params.get("on_error", "skip").asString() != "keep"
+		   && columns.isObject() && columns.isMember("x") && columns.isMember("y");
+}
+
+bool PangaeaTabParser::hasQuotes(const char *begin, const char *end) {
+	return std::memchr(begin, '"', static_cast<size_t>(end - begin)) != nullptr;
+}
+
+PangaeaTabParser::PangaeaTabParser(const std::vector<std::string> &columnNames, const Json::Value &params) {
+	separator = '\t';
+	abortOnError = params.get("on_error", "skip").asString() == "abort";
+
+	const Json::Value &columns = params["columns"];
+	columnX = findColumn(columnNames, columns.get("x", "").asString());
+	columnY = findColumn(columnNames, columns.get("y", "").asString());
+
+	for(auto &column : columns.get("numeric", Json::Value(Json::arrayValue))) {
+		numericColumns.emplace_back(column.asString(), findColumn(columnNames, column.asString()));
+	}
+
+	for(auto &column : columns.get("textual", Json::Value(Json::arrayValue))) {
+		textualColumns.emplace_back(column.asString(), findColumn(columnNames, column.asString()));
+	}
+
+	lastColumn = std::max(columnX, columnY);
+	for(auto &column : numericColumns) {
+		lastColumn = std::max(lastColumn, column.second);
+	}
+	for(auto &column : textualColumns) {
+		lastColumn = std::max(lastColumn, column.second);
+	}
+}
+
+size_t PangaeaTabParser::findColumn(const std::vector<std::string> &columnNames, const std::string &name) const {
+	auto it = std::find(columnNames.begin(), columnNames.end(), name);
+	if(it == columnNames.end()) {
+		throw ArgumentException(concat("PangaeaTabParser: column not found: ", name));
+	}
+	return static_cast<size_t>(it - columnNames.begin());
+}
+
+std::unique_ptr<PointCollection> PangaeaTabParser::createCollection(const QueryRectangle &rect) const {
+	auto points = make_unique<PointCollection>(rect);
+
+	for(auto &column : numericColumns) {
+		points->feature_attributes.addNumericAttribute(column.first, Unit::unknown());
+	}
+
+	for(auto &column : textualColumns) {
+		points->feature_attributes.addTextualAttribute(column.first, Unit::unknown());
+	}
+
+	return points;
+}
+
+void PangaeaTabParser::parse(const char *begin, const char *end, PointCollection &points) const {
+	// resolve the attribute arrays once instead of per feature
+	std::vector<decltype(&points.feature_attributes.numeric(std::string()))> numericArrays;
+	for(auto &column : numericColumns) {
+		numericArrays.push_back(&points.feature_attributes.numeric(column.first));
+	}
+	std::vector<decltype(&points.feature_attributes.textual(std::string()))> textualArrays;
+	for(auto &column : textualColumns) {
+		textualArrays.push_back(&points.feature_attributes.textual(column.first));
+	}
+
+	// begin and end of every field of the current line
+	std::vector<std::pair<const char*, const char*>> fields;
+
+	const char *position = begin;
+	while(position < end) {
+		fields.clear();
+		const char *lineBegin = position;
+
+		// fields after the last requested column are not tokenized
+		const char *lineEnd = nullptr;
+		while(fields.size() <= lastColumn) {
+			const char *fieldEnd = TabScanner::findDelimiter(position, end, separator);
+			fields.emplace_back(position, fieldEnd);
+
+			if(fieldEnd == end || *fieldEnd == '\n') {
+				lineEnd = fieldEnd;
+				break;
+			}
+			position = fieldEnd + 1;
+		}
+		if(lineEnd == nullptr) {
+			lineEnd = TabScanner::findLineEnd(position, end);
+		}
+		position = lineEnd + 1;
+
+		// handle windows line breaks
+		if(fields.back().second > fields.back().first && *(fields.back().second - 1) == '\r') {
+			--fields.back().second;
+		}
+
+		if(fields.size() == 1 && fields[0].first == fields[0].second) {
+			// empty line
+			continue;
+		}
+
+		double x, y;
+		bool valid = columnX < fields.size() && columnY < fields.size()
+					 && TabScanner::parseDouble(fields[columnX].first, fields[columnX].second, x)
+					 && TabScanner::parseDouble(fields[columnY].first, fields[columnY].second, y);
+		if(!valid) {
+			if(abortOnError) {
+				throw OperatorException(concat("PangaeaTabParser: invalid coordinates in line: ", std::string(lineBegin, lineEnd)));
+			}
+			continue;
+		}
+
+		points.addSinglePointFeature(Coordinate(x, y));
+		size_t feature = points.getFeatureCount() - 1;
+
+		for(size_t i = 0; i < numericColumns.size(); ++i) {
+			size_t column = numericColumns[i].second;
+			double value = NAN;
+			if(column < fields.size() && !TabScanner::parseDouble(fields[column].first, fields[column].second, value)) {
+				value = NAN;
+			}
+			numericArrays[i]->set(feature, value);
+		}
+
+		for(size_t i = 0; i < textualColumns.size(); ++i) {
+			size_t column = textualColumns[i].second;
+			if(column < fields.size()) {
+				textualArrays[i]->set(feature, std::string(fields[column].first, fields[column].second));
+			} else {
+				textualArrays[i]->set(feature, "");
+			}
+		}
+	}
+}
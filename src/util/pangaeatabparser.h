@@ -0,0 +1,73 @@
+#ifndef UTIL_PANGAEATABPARSER_H_
+#define UTIL_PANGAEATABPARSER_H_
+
+#include "datatypes/pointcollection.h"
+
+#include <json/json.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Fast parser for the tab separated data of Pangaea data sets.
+ *
+ * It handles the common case of point data with x/y columns and no time columns and builds
+ * the point collection directly from the raw bytes, using vectorized delimiter scanning and
+ * exact fast path float conversion. Only the requested columns are tokenized and converted.
+ * Use `isApplicable` to check whether the parameters of a query can be handled; all other
+ * cases are left to the generic CSV parser.
+ *
+ * Unlike CSVSourceUtil, the parser does not handle quoted fields: quotes are kept as part of the
+ * field and separators or line breaks inside quotes split the field. Data containing quotes has
+ * to be left to the generic CSV parser, see `hasQuotes`. Numbers are converted like std::strtod,
+ * so `nan` and `inf` are valid values; points with non finite coordinates are dropped by the
+ * spatial filter of the collection.
+ */
+class PangaeaTabParser {
+public:
+	/**
+	 * @param columnNames the names of all columns of the data set, in file order
+	 * @param params the CSV parameters of the operator
+	 */
+	PangaeaTabParser(const std::vector<std::string> &columnNames, const Json::Value &params);
+
+	/**
+	 * @return true if the given CSV parameters can be handled by this parser
+	 */
+	static bool isApplicable(const Json::Value &params);
+
+	/**
+	 * @return true if [begin, end) contains quotes, which are only handled by the generic CSV parser
+	 */
+	static bool hasQuotes(const char *begin, const char *end);
+
+	/**
+	 * create an empty collection with all requested attributes
+	 */
+	std::unique_ptr<PointCollection> createCollection(const QueryRectangle &rect) const;
+
+	/**
+	 * parse the lines in [begin, end) without header and append them to the collection
+	 */
+	void parse(const char *begin, const char *end, PointCollection &points) const;
+
+private:
+	size_t findColumn(const std::vector<std::string> &columnNames, const std::string &name) const;
+
+	char separator;
+	bool abortOnError;
+
+	size_t columnX;
+	size_t columnY;
+
+	/**
+	 * index of the last column that is needed, the rest of a line is skipped
+	 */
+	size_t lastColumn;
+
+	std::vector<std::pair<std::string, size_t>> numericColumns;
+	std::vector<std::pair<std::string, size_t>> textualColumns;
+};
+
+#endif /* UTIL_PANGAEATABPARSER_H_ */
@@ -0,0 +1,96 @@
+#include "sharedcache.h"
+
+#include "util/configuration.h"
+#include "util/concat.h"
+
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+SharedCache::SharedCache(const std::string &directory, size_t maxSize) : cache(directory, maxSize, 256) {
+}
+
+std::string SharedCache::getDirectory(const std::string &name) {
+	std::string path = Configuration::get<std::string>("sharedcache.path", "");
+	return path.empty() ? "" : concat(path, "/", name);
+}
+
+std::shared_ptr<SharedCache> SharedCache::get(const std::string &name) {
+	// one instance per kind of data, so eviction is triggered by the writes of the whole process
+	static std::mutex mutex;
+	static std::map<std::string, std::shared_ptr<SharedCache>> caches;
+
+	std::string directory = getDirectory(name);
+	if(directory.empty()) {
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto &sharedCache = caches[name];
+	if(!sharedCache) {
+		size_t maxSize = static_cast<size_t>(Configuration::get<int>("sharedcache.size", 64)) * 1024 * 1024;
+		sharedCache = std::make_shared<SharedCache>(directory, maxSize);
+	}
+	return sharedCache;
+}
+
+std::string SharedCache::getFileName(const std::string &key) {
+	// FNV-1a, file names derived from the keys themselves could collide after sanitizing
+	uint64_t hash = 14695981039346656037ULL;
+	for(char c : key) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+	return name;
+}
+
+/*
+ * An entry consists of the line "<expiration time> <key length>", followed by the key and the value.
+ */
+bool SharedCache::get(const std::string &key, std::string &value, time_t *expires) const {
+	std::string content;
+	if(!cache.get(getFileName(key), content)) {
+		return false;
+	}
+
+	size_t lineEnd = content.find('\n');
+	if(lineEnd == std::string::npos) {
+		return false;
+	}
+
+	std::istringstream header(content.substr(0, lineEnd));
+	int64_t expiration;
+	size_t keyLength;
+	if(!(header >> expiration >> keyLength) || lineEnd + 1 + keyLength > content.size()
+			|| content.compare(lineEnd + 1, keyLength, key) != 0) {
+		return false;
+	}
+
+	if(expiration <= time(nullptr)) {
+		// expired entries would otherwise only be removed once the size limit is reached
+		cache.remove(getFileName(key));
+		return false;
+	}
+
+	if(expires != nullptr) {
+		*expires = static_cast<time_t>(expiration);
+	}
+	value = content.substr(lineEnd + 1 + keyLength);
+	return true;
+}
+
+void SharedCache::put(const std::string &key, const std::string &value, time_t ttl) const {
+	putUntil(key, value, time(nullptr) + ttl);
+}
+
+void SharedCache::putUntil(const std::string &key, const std::string &value, time_t expires) const {
+	try {
+		cache.put(getFileName(key), concat(static_cast<int64_t>(expires), ' ', key.size(), '\n', key, value));
+	} catch (const std::exception&) {
+		// caching is best effort, a full or read only file system must not fail the query
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef UTIL_SHAREDCACHE_H_
+#define UTIL_SHAREDCACHE_H_
+
+#include "util/filecache.h"
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+
+/**
+ * Node-local key/value store shared by all worker processes of a node.
+ *
+ * The entries are files in a directory on a memory backed file system, e.g. below /dev/shm,
+ * so a value stored by one worker is immediately available to all others without a disk
+ * access. Every kind of data has its own directory and size limit. The cache is disabled
+ * unless a directory is configured.
+ *
+ * Entries are named by a hash of the key and contain the full key and the time at
+ * which they expire. Expired entries are removed when they are read.
+ */
+class SharedCache {
+public:
+	/**
+	 * @param directory the directory of the entries
+	 * @param maxSize the maximum size of the entries in bytes, 0 for no limit
+	 */
+	SharedCache(const std::string &directory, size_t maxSize);
+
+	/**
+	 * the cache for one kind of data, e.g. "terms", configured by the sharedcache settings
+	 * @return the cache or nullptr if the shared cache is disabled
+	 */
+	static std::shared_ptr<SharedCache> get(const std::string &name);
+
+	/**
+	 * @return the directory for one kind of data or an empty string if the shared cache is disabled
+	 */
+	static std::string getDirectory(const std::string &name);
+
+	/**
+	 * read the entry for the key
+	 * @param expires set to the time at which the entry expires, if not nullptr
+	 * @return false if there is no valid entry for the key
+	 */
+	bool get(const std::string &key, std::string &value, time_t *expires = nullptr) const;
+
+	/**
+	 * store the value for the key. Errors are ignored, the entry is just missing then.
+	 * @param ttl the number of seconds the entry is valid
+	 */
+	void put(const std::string &key, const std::string &value, time_t ttl) const;
+
+	/**
+	 * store the value for the key with the given expiration time
+	 */
+	void putUntil(const std::string &key, const std::string &value, time_t expires) const;
+
+private:
+	static std::string getFileName(const std::string &key);
+
+	FileCache cache;
+};
+
+#endif /* UTIL_SHAREDCACHE_H_ */
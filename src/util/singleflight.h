@@ -0,0 +1,105 @@
+#ifndef UTIL_SINGLEFLIGHT_H_
+#define UTIL_SINGLEFLIGHT_H_
+
+#include <map>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * Coalesces concurrent requests for the same key.
+ *
+ * The first caller for a key becomes the leader of the flight and performs the request,
+ * all callers arriving while the flight is in progress share its result.
+ * Results are not kept after the flight completed.
+ */
+template<typename Key, typename Value>
+class SingleFlight {
+public:
+	/**
+	 * Held by the leader of a flight. Completing the lease hands the result to all waiting callers.
+	 * A lease that is destroyed without being completed fails the flight.
+	 */
+	class Lease {
+	public:
+		Lease(SingleFlight &flights, const Key &key) : flights(flights), key(key), completed(false) {}
+
+		~Lease() {
+			if(!completed) {
+				fail(std::make_exception_ptr(std::runtime_error("SingleFlight: flight was abandoned")));
+			}
+		}
+
+		void complete(const Value &value) {
+			flights.finish(key);
+			completed = true;
+			promise.set_value(value);
+		}
+
+		void fail(std::exception_ptr error) {
+			flights.finish(key);
+			completed = true;
+			promise.set_exception(error);
+		}
+
+	private:
+		friend class SingleFlight;
+
+		SingleFlight &flights;
+		Key key;
+		bool completed;
+		std::promise<Value> promise;
+	};
+
+	/**
+	 * join the flight for the given key
+	 * @param future the shared result of the flight
+	 * @return the lease if the caller is the leader of the flight, nullptr otherwise
+	 */
+	std::unique_ptr<Lease> join(const Key &key, std::shared_future<Value> &future) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = flights.find(key);
+		if(it != flights.end()) {
+			future = it->second;
+			return nullptr;
+		}
+
+		std::unique_ptr<Lease> lease(new Lease(*this, key));
+		future = lease->promise.get_future().share();
+		flights.emplace(key, future);
+
+		return lease;
+	}
+
+	/**
+	 * call the function for the given key, unless a call for the same key is already in flight
+	 */
+	Value run(const Key &key, const std::function<Value()> &function) {
+		std::shared_future<Value> future;
+		auto lease = join(key, future);
+
+		if(lease) {
+			try {
+				lease->complete(function());
+			} catch (...) {
+				lease->fail(std::current_exception());
+			}
+		}
+
+		return future.get();
+	}
+
+private:
+	void finish(const Key &key) {
+		std::lock_guard<std::mutex> lock(mutex);
+		flights.erase(key);
+	}
+
+	std::mutex mutex;
+	std::map<Key, std::shared_future<Value>> flights;
+};
+
+#endif /* UTIL_SINGLEFLIGHT_H_ */
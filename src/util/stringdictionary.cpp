@@ -0,0 +1,21 @@
+#include "stringdictionary.h"
+
+StringDictionary::Code StringDictionary::encode(const std::string &value) {
+	auto it = codes.find(value);
+	if(it != codes.end()) {
+		return it->second;
+	}
+
+	Code code = static_cast<Code>(values.size());
+	values.push_back(value);
+	codes.emplace(value, code);
+	return code;
+}
+
+const std::vector<std::string> &StringDictionary::getValues() const {
+	return values;
+}
+
+size_t StringDictionary::size() const {
+	return values.size();
+}
@@ -0,0 +1,54 @@
+#ifndef UTIL_STRINGDICTIONARY_H_
+#define UTIL_STRINGDICTIONARY_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Dictionary encoding of a textual column. Every distinct value is stored once and gets an
+ * integer code, in order of first occurrence, so work per value, like resolving terms, is
+ * done once per distinct value and mapped back to the features by their codes.
+ */
+class StringDictionary {
+public:
+	typedef uint32_t Code;
+
+	/**
+	 * @return the code of the value, a new one if the value was not seen before
+	 */
+	Code encode(const std::string &value);
+
+	const std::string &decode(Code code) const {
+		return values[code];
+	}
+
+	/**
+	 * @return the distinct values, indexed by their codes
+	 */
+	const std::vector<std::string> &getValues() const;
+
+	size_t size() const;
+
+	/**
+	 * encode a whole column
+	 * @param get returns the value of a feature
+	 * @return the codes of the features
+	 */
+	template<typename Getter>
+	std::vector<Code> encodeAll(size_t count, const Getter &get) {
+		std::vector<Code> result;
+		result.reserve(count);
+		for(size_t i = 0; i < count; ++i) {
+			result.push_back(encode(get(i)));
+		}
+		return result;
+	}
+
+private:
+	std::vector<std::string> values;
+	std::unordered_map<std::string, Code> codes;
+};
+
+#endif /* UTIL_STRINGDICTIONARY_H_ */
@@ -0,0 +1,318 @@
+#ifndef UTIL_TABSCANNER_H_
+#define UTIL_TABSCANNER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Low level helpers for tokenizing delimiter separated text and converting numeric fields.
+ * They are defined inline, as they are called for every single field of a data set.
+ */
+class TabScanner {
+public:
+	/**
+	 * find the next field separator or line break
+	 * @return pointer to the first separator or '\n' in [begin, end), end if there is none
+	 */
+	static const char *findDelimiter(const char *begin, const char *end, char separator) {
+#ifdef __SSE2__
+		// compare 16 bytes at once
+		const __m128i separators = _mm_set1_epi8(separator);
+		const __m128i newlines = _mm_set1_epi8('\n');
+		while(end - begin >= 16) {
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+			int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, separators), _mm_cmpeq_epi8(block, newlines)));
+			if(mask != 0) {
+				return begin + __builtin_ctz(static_cast<unsigned int>(mask));
+			}
+			begin += 16;
+		}
+#endif
+		while(begin < end && *begin != separator && *begin != '\n') {
+			++begin;
+		}
+		return begin;
+	}
+
+	/**
+	 * find the next line break
+	 * @return pointer to the first '\n' in [begin, end), end if there is none
+	 */
+	static const char *findLineEnd(const char *begin, const char *end) {
+		const void *position = std::memchr(begin, '\n', static_cast<size_t>(end - begin));
+		return position == nullptr ? end : static_cast<const char*>(position);
+	}
+
+	/**
+	 * find the end of the field that starts at begin. Separators and line breaks inside a quoted
+	 * field are skipped, with the quoting rules of CSVSourceUtil (see endsInsideQuotes).
+	 * @return pointer to the separator or '\n' after the field, end if there is none
+	 */
+	static const char *findFieldEnd(const char *begin, const char *end, char separator) {
+		if(begin == end || *begin != '"') {
+			return findDelimiter(begin, end, separator);
+		}
+
+		const char *position = begin + 1;
+		while(position < end) {
+			const void *quote = std::memchr(position, '"', static_cast<size_t>(end - position));
+			if(quote == nullptr) {
+				return end;
+			}
+			position = static_cast<const char*>(quote) + 1;
+
+			// "" is an escaped quote
+			if(position < end && *position == '"') {
+				++position;
+			} else {
+				break;
+			}
+		}
+		return findDelimiter(position, end, separator);
+	}
+
+	/**
+	 * find the end of the record whose field starts at begin, skipping line breaks inside quoted fields
+	 * @return pointer to the '\n' that ends the record, end if there is none
+	 */
+	static const char *findRecordEnd(const char *begin, const char *end, char separator) {
+		const char *lineEnd = findLineEnd(begin, end);
+		if(std::memchr(begin, '"', static_cast<size_t>(lineEnd - begin)) == nullptr) {
+			return lineEnd;
+		}
+
+		const char *fieldEnd = findFieldEnd(begin, end, separator);
+		while(fieldEnd < end && *fieldEnd != '\n') {
+			fieldEnd = findFieldEnd(fieldEnd + 1, end, separator);
+		}
+		return fieldEnd;
+	}
+
+	/**
+	 * Scan the lines in [begin, end) for quoted fields, with the quoting rules of CSVSourceUtil:
+	 * a field that starts with '"' is quoted. It may contain separators and line breaks and
+	 * escapes '"' as "". Quotes inside unquoted fields are plain characters.
+	 * @param insideQuotes whether begin lies inside a quoted field, otherwise it must be the start of a line
+	 * @return whether end lies inside a quoted field
+	 */
+	static bool endsInsideQuotes(const char *begin, const char *end, char separator, bool insideQuotes) {
+		if(std::memchr(begin, '"', static_cast<size_t>(end - begin)) == nullptr) {
+			return insideQuotes;
+		}
+
+		bool fieldStart = !insideQuotes;
+		for(const char *p = begin; p < end; ++p) {
+			if(insideQuotes) {
+				if(*p == '"') {
+					if(p + 1 < end && p[1] == '"') {
+						++p;
+					} else {
+						insideQuotes = false;
+					}
+				}
+			} else if(*p == '"' && fieldStart) {
+				insideQuotes = true;
+				fieldStart = false;
+			} else {
+				fieldStart = *p == separator || *p == '\n';
+			}
+		}
+		return insideQuotes;
+	}
+
+	/**
+	 * Read a chunk of at least size bytes that ends with a complete record, i.e. at a line break
+	 * outside of quoted fields, so the chunks of a stream can be parsed independently.
+	 * The stream must be positioned at the start of a record.
+	 * @return false if the stream has no more data
+	 */
+	static bool readChunk(std::istream &in, size_t size, char separator, std::string &chunk) {
+		chunk.resize(size);
+		in.read(&chunk[0], static_cast<std::streamsize>(size));
+		chunk.resize(static_cast<size_t>(in.gcount()));
+
+		// complete the last record of the chunk, a quoted field may continue over several lines
+		std::string line;
+		bool insideQuotes = false;
+		size_t scanned = 0;
+		while(std::getline(in, line)) {
+			chunk += line;
+			chunk += '\n';
+			insideQuotes = endsInsideQuotes(chunk.data() + scanned, chunk.data() + chunk.size(), separator, insideQuotes);
+			scanned = chunk.size();
+			if(!insideQuotes) {
+				break;
+			}
+		}
+
+		return !chunk.empty();
+	}
+
+	/**
+	 * copy only the fields with the given indices of every line in [begin, end) to the output.
+	 * Lines are processed only up to the last selected field. Quoted fields are copied with
+	 * their quotes and may contain separators and line breaks.
+	 * @param indices the selected field indices in ascending order
+	 */
+	static void projectFields(const char *begin, const char *end, char separator,
+							  const std::vector<size_t> &indices, std::string &out) {
+		const char *position = begin;
+		while(position < end) {
+			const char *lineEnd = nullptr;
+			size_t field = 0;
+			size_t selected = 0;
+			while(selected < indices.size()) {
+				const char *fieldEnd = findFieldEnd(position, end, separator);
+				if(field == indices[selected]) {
+					if(selected > 0) {
+						out += separator;
+					}
+					out.append(position, fieldEnd);
+					++selected;
+				}
+				++field;
+
+				if(fieldEnd == end || *fieldEnd == '\n') {
+					lineEnd = fieldEnd;
+					break;
+				}
+				position = fieldEnd + 1;
+			}
+
+			if(lineEnd == nullptr) {
+				lineEnd = findRecordEnd(position, end, separator);
+			}
+			// strip windows line breaks of unselected last fields
+			if(!out.empty() && out.back() == '\r') {
+				out.pop_back();
+			}
+			out += '\n';
+			position = lineEnd + 1;
+		}
+	}
+
+	/**
+	 * Parse a floating point number from the field, with the same result as std::strtod.
+	 *
+	 * Decimal numbers with up to 19 significant digits whose mantissa and power of ten are
+	 * exactly representable as double are converted with a single, correctly rounded
+	 * multiplication or division (Clinger's fast path). All other inputs are handed to strtod.
+	 * Like std::stod, leading whitespace and trailing characters are ignored.
+	 *
+	 * @return false if the field does not start with a number
+	 */
+	static bool parseDouble(const char *begin, const char *end, double &value) {
+		while(begin < end && (*begin == ' ' || *begin == '\t')) {
+			++begin;
+		}
+
+		const char *p = begin;
+		bool negative = false;
+		if(p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			++p;
+		}
+
+		uint64_t mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool anyDigit = false;
+
+		for(; p < end && *p >= '0' && *p <= '9'; ++p) {
+			anyDigit = true;
+			if(mantissa == 0 && *p == '0') {
+				continue;
+			}
+			if(digits < 19) {
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+				++digits;
+			} else {
+				return parseSlow(begin, end, value);
+			}
+		}
+
+		if(p < end && *p == '.') {
+			++p;
+			for(; p < end && *p >= '0' && *p <= '9'; ++p) {
+				anyDigit = true;
+				if(mantissa == 0 && *p == '0') {
+					--exponent;
+					continue;
+				}
+				if(digits < 19) {
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+					++digits;
+					--exponent;
+				} else {
+					return parseSlow(begin, end, value);
+				}
+			}
+		}
+
+		if(!anyDigit || (p < end && (*p == 'x' || *p == 'X'))) {
+			// inf, nan, hexadecimal numbers or no number at all
+			return parseSlow(begin, end, value);
+		}
+
+		if(p < end && (*p == 'e' || *p == 'E')) {
+			const char *q = p + 1;
+			bool negativeExponent = false;
+			if(q < end && (*q == '-' || *q == '+')) {
+				negativeExponent = *q == '-';
+				++q;
+			}
+			if(q < end && *q >= '0' && *q <= '9') {
+				int explicitExponent = 0;
+				for(; q < end && *q >= '0' && *q <= '9'; ++q) {
+					if(explicitExponent < 100000) {
+						explicitExponent = explicitExponent * 10 + (*q - '0');
+					}
+				}
+				exponent += negativeExponent ? -explicitExponent : explicitExponent;
+			}
+		}
+
+		if(mantissa == 0) {
+			value = negative ? -0.0 : 0.0;
+			return true;
+		}
+
+		static const double powersOfTen[] = {
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		if(mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22) {
+			return parseSlow(begin, end, value);
+		}
+
+		double result = static_cast<double>(mantissa);
+		if(exponent < 0) {
+			result /= powersOfTen[-exponent];
+		} else {
+			result *= powersOfTen[exponent];
+		}
+
+		value = negative ? -result : result;
+		return true;
+	}
+
+private:
+	static bool parseSlow(const char *begin, const char *end, double &value) {
+		// strtod needs a terminated string
+		std::string field(begin, end);
+		char *parsedEnd;
+		value = std::strtod(field.c_str(), &parsedEnd);
+		return parsedEnd != field.c_str();
+	}
+};
+
+#endif /* UTIL_TABSCANNER_H_ */
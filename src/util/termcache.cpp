@@ -0,0 +1,141 @@
+#include "termcache.h"
+
+#include "util/configuration.h"
+#include "util/concat.h"
+
+#include <algorithm>
+#include <functional>
+
+std::string TermCache::Key::toString() const {
+	// the unit separator does not occur in the parameters
+	return concat(terminology, '\x1f', term, '\x1f', key, '\x1f', matchType, '\x1f', firstHit ? "1" : "0");
+}
+
+TermCache::TermCache(size_t capacity, std::shared_ptr<SharedCache> shared, int64_t ttl, int64_t negativeTtl)
+		: shards(SHARDS), shardCapacity(std::max<size_t>(1, capacity / SHARDS)), shared(std::move(shared)),
+		  ttl(ttl), negativeTtl(negativeTtl), memoryHits(0), sharedHits(0), misses(0) {
+}
+
+TermCache &TermCache::getInstance() {
+	static TermCache cache(
+			static_cast<size_t>(std::max(0, Configuration::get<int>("terminology.cache.entries", 100000))),
+			[]() -> std::shared_ptr<SharedCache> {
+				// a persistent directory keeps the terms across restarts, otherwise the node's shared memory is used
+				std::string cachePath = Configuration::get<std::string>("terminology.cache.path", "");
+				size_t maxSize = static_cast<size_t>(std::max(1, Configuration::get<int>("terminology.cache.size", 256))) * 1024 * 1024;
+				return cachePath.empty() ? SharedCache::get("terms") : std::make_shared<SharedCache>(cachePath + "/terms", maxSize);
+			}(),
+			Configuration::get<int>("terminology.cache.ttl", 604800),
+			Configuration::get<int>("terminology.cache.negativettl", 3600));
+	return cache;
+}
+
+TermCache::Shard &TermCache::getShard(const std::string &key) {
+	return shards[std::hash<std::string>()(key) % SHARDS];
+}
+
+bool TermCache::get(const Key &key, bool &resolved, std::string &value) {
+	std::string cacheKey = key.toString();
+
+	if(getFromMemory(cacheKey, resolved, value)) {
+		++memoryHits;
+		return true;
+	}
+
+	Entry entry;
+	if(getFromSharedCache(cacheKey, entry)) {
+		++sharedHits;
+		resolved = entry.resolved;
+		value = entry.value;
+		putIntoMemory(std::move(entry));
+		return true;
+	}
+
+	++misses;
+	return false;
+}
+
+void TermCache::put(const Key &key, bool resolved, const std::string &value) {
+	Entry entry;
+	entry.key = key.toString();
+	entry.resolved = resolved;
+	entry.value = resolved ? value : "";
+	entry.expires = Clock::now() + (resolved ? ttl : negativeTtl);
+
+	putIntoSharedCache(entry);
+	putIntoMemory(std::move(entry));
+}
+
+TermCache::Statistics TermCache::getStatistics() const {
+	Statistics statistics;
+	statistics.memoryHits = memoryHits;
+	statistics.sharedHits = sharedHits;
+	statistics.misses = misses;
+	return statistics;
+}
+
+bool TermCache::getFromMemory(const std::string &key, bool &resolved, std::string &value) {
+	Shard &shard = getShard(key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.index.find(key);
+	if(it == shard.index.end()) {
+		return false;
+	}
+
+	if(it->second->expires <= Clock::now()) {
+		shard.entries.erase(it->second);
+		shard.index.erase(it);
+		return false;
+	}
+
+	// mark as most recently used
+	shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+	resolved = it->second->resolved;
+	value = it->second->value;
+	return true;
+}
+
+void TermCache::putIntoMemory(Entry entry) {
+	Shard &shard = getShard(entry.key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.index.find(entry.key);
+	if(it != shard.index.end()) {
+		shard.entries.erase(it->second);
+		shard.index.erase(it);
+	}
+
+	shard.entries.push_front(std::move(entry));
+	shard.index[shard.entries.front().key] = shard.entries.begin();
+
+	while(shard.entries.size() > shardCapacity) {
+		shard.index.erase(shard.entries.back().key);
+		shard.entries.pop_back();
+	}
+}
+
+/*
+ * A shared entry is the resolved flag followed by the value.
+ */
+bool TermCache::getFromSharedCache(const std::string &key, Entry &entry) const {
+	std::string content;
+	time_t expires;
+	if(!shared || !shared->get(key, content, &expires) || content.empty()) {
+		return false;
+	}
+
+	entry.key = key;
+	entry.resolved = content[0] == '1';
+	entry.value = content.substr(1);
+	entry.expires = Clock::from_time_t(expires);
+	return true;
+}
+
+void TermCache::putIntoSharedCache(const Entry &entry) const {
+	if(!shared) {
+		return;
+	}
+
+	shared->putUntil(entry.key, concat(entry.resolved ? '1' : '0', entry.value), Clock::to_time_t(entry.expires));
+}
@@ -0,0 +1,107 @@
+#ifndef UTIL_TERMCACHE_H_
+#define UTIL_TERMCACHE_H_
+
+#include "util/sharedcache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Cache of terminology lookups, keyed by the search parameters and the result key.
+ *
+ * Entries are kept in a sharded in-memory LRU and in a store shared by all worker
+ * processes of the node, so a term resolved by one worker is a hit for all others.
+ * Terms that could not be resolved are cached as well, with a shorter time to live.
+ * The hit counters of the process are logged with every terminology query.
+ */
+class TermCache {
+public:
+	struct Key {
+		std::string terminology;
+		std::string term;
+		std::string key;
+		std::string matchType;
+		bool firstHit;
+
+		std::string toString() const;
+	};
+
+	struct Statistics {
+		uint64_t memoryHits;
+		uint64_t sharedHits;
+		uint64_t misses;
+	};
+
+	/**
+	 * @param capacity the maximum number of entries in memory
+	 * @param shared the store shared with other processes, nullptr to keep entries in memory only
+	 * @param ttl the seconds a resolved term is valid
+	 * @param negativeTtl the seconds a term that could not be resolved is valid
+	 */
+	TermCache(size_t capacity, std::shared_ptr<SharedCache> shared, int64_t ttl, int64_t negativeTtl);
+
+	TermCache(const TermCache&) = delete;
+	TermCache &operator=(const TermCache&) = delete;
+
+	/**
+	 * the cache of the process, configured by the terminology.cache settings
+	 */
+	static TermCache &getInstance();
+
+	/**
+	 * look up the term
+	 * @param resolved set to false if the term is known to be not resolvable
+	 * @param value the resolved term
+	 * @return false if there is no valid entry
+	 */
+	bool get(const Key &key, bool &resolved, std::string &value);
+
+	void put(const Key &key, bool resolved, const std::string &value);
+
+	Statistics getStatistics() const;
+
+private:
+	using Clock = std::chrono::system_clock;
+
+	struct Entry {
+		std::string key;
+		bool resolved;
+		std::string value;
+		Clock::time_point expires;
+	};
+
+	struct Shard {
+		std::mutex mutex;
+		std::list<Entry> entries;
+		std::unordered_map<std::string, std::list<Entry>::iterator> index;
+	};
+
+	Shard &getShard(const std::string &key);
+
+	bool getFromMemory(const std::string &key, bool &resolved, std::string &value);
+	void putIntoMemory(Entry entry);
+
+	bool getFromSharedCache(const std::string &key, Entry &entry) const;
+	void putIntoSharedCache(const Entry &entry) const;
+
+	static const size_t SHARDS = 16;
+
+	std::vector<Shard> shards;
+	size_t shardCapacity;
+	std::shared_ptr<SharedCache> shared;
+	std::chrono::seconds ttl;
+	std::chrono::seconds negativeTtl;
+
+	std::atomic<uint64_t> memoryHits;
+	std::atomic<uint64_t> sharedHits;
+	std::atomic<uint64_t> misses;
+};
+
+#endif /* UTIL_TERMCACHE_H_ */
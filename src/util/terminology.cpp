@@ -1,16 +1,18 @@
 
 #include "terminology.h"
 #include <vector>
-#include <iostream>
-#include <future>
-#include "util/make_unique.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
 #include "util/configuration.h"
-
-#include <boost/shared_ptr.hpp>
-#include <boost/make_shared.hpp>
-#include <boost/thread.hpp>
-#include <boost/asio.hpp>
-#include <boost/move/move.hpp>
+#include "util/concat.h"
+#include "util/log.h"
+#include "util/adaptivelimiter.h"
+#include "util/jsonextractor.h"
+#include "util/httpclient.h"
+#include "util/stringdictionary.h"
+#include "util/termcache.h"
+#include "util/terminologysnapshot.h"
 
 std::vector<std::string> Terminology::resolveMultiple(const std::vector<std::string> &names_in,
                                                       const std::string &terminology,
@@ -19,201 +21,287 @@ std::vector<std::string> Terminology::resolveMultiple(const std::vector<std::str
                                                       const bool first_hit,
                                                       const HandleNotResolvable on_not_resolvable){
 
-    std::vector<std::string> names_out;
-    if(names_in.empty())
-        return names_out;
-    names_out.reserve(names_in.size());
-
-    //get a set with all names to be resolved (so we don't request the same name multiple times)
-    std::set<std::string> to_resolve;
-    std::map<std::string, std::string> resolved_pairs;
+    return resolveMultipleKeys(names_in, terminology, std::vector<std::string> {key}, match_type, first_hit, on_not_resolvable)[0];
+}
 
-    for(auto &name : names_in){
-        to_resolve.insert(name);
+std::vector<std::vector<std::string>> Terminology::resolveMultipleKeys(const std::vector<std::string> &names_in,
+                                                                       const std::string &terminology,
+                                                                       const std::vector<std::string> &keys,
+                                                                       const std::string &match_type,
+                                                                       const bool first_hit,
+                                                                       const HandleNotResolvable on_not_resolvable){
+
+    //encode the names, so every distinct name is only resolved once
+    StringDictionary dictionary;
+    std::vector<StringDictionary::Code> codes = dictionary.encodeAll(names_in.size(), [&](size_t i) -> const std::string & {
+        return names_in[i];
+    });
+
+    auto distinct_out = resolveDistinct(dictionary.getValues(), terminology, keys, match_type, first_hit, on_not_resolvable);
+
+    //insert values from resolved terms into names_out, one vector per key
+    std::vector<std::vector<std::string>> names_out(keys.size());
+    for(size_t k = 0; k < keys.size(); k++){
+        names_out[k].reserve(names_in.size());
+        for(auto code : codes)
+            names_out[k].push_back(distinct_out[k][code]);
     }
 
-    //aliases only needed in this method.
-    using task_t  = boost::packaged_task<string_pair>;
-    using ptask_t = boost::shared_ptr<task_t>;
+    return names_out;
+}
 
-    //init thread pool
-    int threads_num = Configuration::get<int>("terminology.threads",16);
-    if(threads_num > to_resolve.size())
-        threads_num = to_resolve.size();
+std::vector<std::vector<std::string>> Terminology::resolveDistinct(const std::vector<std::string> &distinct_names,
+                                                                   const std::string &terminology,
+                                                                   const std::vector<std::string> &keys,
+                                                                   const std::string &match_type,
+                                                                   const bool first_hit,
+                                                                   const HandleNotResolvable on_not_resolvable){
 
-    boost::asio::io_service io_service;
-    boost::thread_group threads;
-    boost::asio::io_service::work work(io_service);
+    std::vector<std::vector<Result>> resolved_terms(distinct_names.size());
 
-    for(int i = 0; i < threads_num; i++){
-        threads.create_thread(boost::bind(&boost::asio::io_service::run, &io_service));
-    }
+    std::shared_ptr<TerminologySnapshot> snapshot = TerminologySnapshot::get(Configuration::get<std::string>("terminology.snapshot.path", ""), terminology);
+    if(snapshot && TerminologySnapshot::supports(match_type)) {
+        // with a local snapshot of the terminology, no requests are needed
+        for(size_t i = 0; i < distinct_names.size(); i++) {
+            resolved_terms[i] = resolveLocally(*snapshot, distinct_names[i], keys, match_type);
+        }
+    } else {
+        // cached names are resolved right away, the others are requested concurrently
+        // from a single event loop on this thread
+        std::vector<size_t> to_request;
+        std::vector<HttpClient::Request> requests;
+
+        for(size_t i = 0; i < distinct_names.size(); i++) {
+            const std::string &name = distinct_names[i];
+            if(!lookupCache(name, terminology, keys, match_type, first_hit, resolved_terms[i])) {
+                to_request.push_back(i);
+                requests.emplace_back(getSearchUrl(name, terminology, match_type, first_hit));
+                requests.back().timeout = Configuration::get<int>("terminology.timeout", 5000);
+            }
+        }
 
-    std::vector<boost::shared_future<string_pair>> pending_results;
-
-    // create context, enable session cache. First name has to be resolved separately
-    // and not in a thread to retrieve the session ptr.
-    Poco::Net::Context::Ptr context = new Poco::Net::Context(
-            Poco::Net::Context::CLIENT_USE,
-            "",
-            Poco::Net::Context::VERIFY_RELAXED,
-            9,
-            true
-    );
-    context->enableSessionCache(true);
-
-    // declare iterator here to take first element, resolve it no in thread
-    auto begin = to_resolve.begin();
-
-    //pair<string_pair, Session::Ptr>
-    auto first_resolved = resolveSingleNameSetSessionPtr(context, *begin, terminology, key, match_type, first_hit, on_not_resolvable);
-    Poco::Net::Session::Ptr session_ptr = first_resolved.second;
-    resolved_pairs.insert(first_resolved.first);
-
-    // move iterator to next element
-    begin++;
-
-    // use iterator to push tasks for all names left into the thread pool
-    for(auto it = begin; it != to_resolve.end(); it++) {
-        const std::string &name = *it;
-        ptask_t task = boost::make_shared<task_t>(
-                boost::bind(resolveSingleNameInternal, context, session_ptr, name, terminology, key, match_type, first_hit, on_not_resolvable));
-        boost::shared_future<string_pair> future(task->get_future());
-        pending_results.push_back(future);
-        io_service.post(boost::bind(&task_t::operator(), task));
+        TermCache::Statistics statistics = TermCache::getInstance().getStatistics();
+        Log::debug("Terminology: %zu of %zu names cached, process totals: %llu memory hits, %llu shared hits, %llu misses",
+                   distinct_names.size() - to_request.size(), distinct_names.size(),
+                   static_cast<unsigned long long>(statistics.memoryHits),
+                   static_cast<unsigned long long>(statistics.sharedHits),
+                   static_cast<unsigned long long>(statistics.misses));
+
+        AdaptiveLimiter &limiter = getLimiter();
+        if(!requests.empty() && !limiter.isAvailable())
+            throw std::runtime_error("Terminology: the terminology server is unavailable, retry later");
+
+        bool failed = false;
+
+        // the limiter adapts the number of concurrent requests and duplicates slow ones
+        HttpClient::performAll(requests, limiter, [&](size_t index, HttpClient::Response &response, std::exception_ptr request_error) {
+            size_t i = to_request[index];
+            bool success = resolveResponse(static_cast<bool>(request_error), response.status, response.body, distinct_names[i],
+                                           terminology, keys, match_type, first_hit, resolved_terms[i]);
+            failed = failed || !success;
+            return success;
+        });
+
+        // single failed requests leave their terms unresolved, only an unavailable server fails the query
+        if(failed && !limiter.isAvailable())
+            throw std::runtime_error("Terminology: the terminology server is unavailable, retry later");
     }
 
-    //get the resolved pairs from the futures, insert into map
-    for(auto &future : pending_results){
-        resolved_pairs.insert(future.get());
+    std::vector<std::vector<std::string>> names_out(keys.size());
+    for(size_t k = 0; k < keys.size(); k++){
+        names_out[k].reserve(distinct_names.size());
+        for(size_t i = 0; i < distinct_names.size(); i++){
+            const Result &result = resolved_terms[i][k];
+            names_out[k].push_back(result.resolved ? result.value : notResolved(distinct_names[i], on_not_resolvable));
+        }
     }
 
-    //insert values from resolved pairs into names_out
-    for(auto &name : names_in){
-        names_out.push_back(resolved_pairs[name]);
-    }
-    
+    return names_out;
 }
 
-/**
- *
- * @return a pair of strings, first string is the string to be resolved and the second is the resolved string.
- */
-Terminology::string_pair Terminology::resolveSingleNameInternal(Poco::Net::Context::Ptr &context,
-                                                   Poco::Net::Session::Ptr &session_ptr,
-                                                   const std::string &name,
-                                                   const std::string &terminology,
-                                                   const std::string &key,
-                                                   const std::string &match_type,
-                                                   const bool first_hit,
-                                                   const HandleNotResolvable &on_not_resolvable)
+AdaptiveLimiter &Terminology::getLimiter()
 {
-    std::string uri_string = Configuration::get<std::string>("terminology.url_search");
-    Poco::URI uri(uri_string);
-    uri.addQueryParameter("query", name);
-    uri.addQueryParameter("terminologies", terminology);
-    uri.addQueryParameter("match_type", match_type);
-    if(first_hit)
-        uri.addQueryParameter("first_hit", "true");
-
-    Poco::Net::HTTPSClientSession session(uri.getHost(), uri.getPort(), context, session_ptr);
-    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, uri.getPathAndQuery(), Poco::Net::HTTPRequest::HTTP_1_1);
-    Poco::Net::HTTPResponse response;
+    static AdaptiveLimiter limiter(
+            static_cast<size_t>(std::max(1, Configuration::get<int>("terminology.inflight", 64))),
+            Configuration::get<int>("terminology.hedge.percentile", 95),
+            static_cast<size_t>(std::max(0, Configuration::get<int>("terminology.breaker.failures", 10))),
+            Configuration::get<int>("terminology.breaker.cooldown", 30));
+    return limiter;
+}
 
-    session.sendRequest(request);
-    std::istream& respStream = session.receiveResponse(response);
+bool Terminology::isOverloaded(const long status)
+{
+    return status >= 500 || status == 429;
+}
 
-    //read response stream into json object
+bool Terminology::resolveResponse(const bool request_failed,
+                                  const long status,
+                                  const std::string &body,
+                                  const std::string &name,
+                                  const std::string &terminology,
+                                  const std::vector<std::string> &keys,
+                                  const std::string &match_type,
+                                  const bool first_hit,
+                                  std::vector<Result> &results)
+{
+    // failed requests and malformed responses are neither resolved nor cached
     Json::Value response_json;
-    if (response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
-    {
-        respStream >> response_json;
-    } else {
-        response_json = Json::Value::null;
+    if(request_failed || isOverloaded(status) || !parseResponse(status, body, response_json)) {
+        results.assign(keys.size(), Result {false, ""});
+        return false;
     }
 
-    //retrieve wanted element from result json, if not valid result return not_resolved.
-    std::string not_resolved = (on_not_resolvable == HandleNotResolvable::EMPTY) ? "" : name;
+    results = storeResults(response_json, name, terminology, keys, match_type, first_hit);
+    return true;
+}
+
+std::string Terminology::getSearchUrl(const std::string &name,
+                                      const std::string &terminology,
+                                      const std::string &match_type,
+                                      const bool first_hit)
+{
+    std::string url = Configuration::get<std::string>("terminology.url_search");
+    url += (url.find('?') == std::string::npos) ? '?' : '&';
+    url += concat("query=", HttpClient::escape(name),
+                  "&terminologies=", HttpClient::escape(terminology),
+                  "&match_type=", HttpClient::escape(match_type));
+    if(first_hit)
+        url += "&first_hit=true";
+    return url;
+}
+
+bool Terminology::parseResponse(const long status, const std::string &body, Json::Value &response_json)
+{
+    response_json = Json::Value::null;
+    if (status != 200)
+        return true;
+
+    // only the first result is used, the others are skipped
+    static const JsonExtractor extractor({"results.0"});
+    return extractor.extract(body, response_json);
+}
+
+bool Terminology::extractResult(const Json::Value &response_json,
+                                const std::string &key,
+                                std::string &result)
+{
+    //retrieve wanted element from result json, if not valid result the term is not resolvable.
     if (response_json.isNull())
-    {
-        return std::make_pair(name, not_resolved);
-    } else
-    {
-        Json::Value results = response_json["results"];
-        if(results.empty())
-            return std::make_pair(name, not_resolved);
-
-        Json::Value val = results[0].get(key, not_resolved);
-        if(val.isArray()){
-            if(val.empty())
-                return std::make_pair(name, not_resolved);
-            else
-                return std::make_pair(name, val[0].asString());
-        }
-        else {
-            return std::make_pair(name, val.asString());
-        }
+        return false;
+
+    Json::Value results = response_json["results"];
+    if(results.empty() || !results[0].isMember(key))
+        return false;
+
+    Json::Value val = results[0][key];
+    if(val.isArray()){
+        if(val.empty())
+            return false;
+        result = val[0].asString();
+    }
+    else {
+        result = val.asString();
     }
+    return true;
 }
 
-/**
- * Same method as resolveSingleNameInternal, but also return the session_ptr to the sslSession of the created HttpsClientSession.
- * @return a pair, first element is a string_pair as in resolveSingleNameInternal, second element is the Session::Ptr.
- */
-Terminology::string_session_ptr_pair
-Terminology::resolveSingleNameSetSessionPtr(Poco::Net::Context::Ptr &context,
-                                            const std::string &name,
-                                            const std::string &terminology,
-                                            const std::string &key,
-                                            const std::string &match_type,
-                                            const bool first_hit,
-                                            const HandleNotResolvable on_not_resolvable) {
-
-    std::string uri_string = Configuration::get<std::string>("terminology.url_search");
-    Poco::URI uri(uri_string);
-    uri.addQueryParameter("query", name);
-    uri.addQueryParameter("terminologies", terminology);
-    uri.addQueryParameter("match_type", match_type);
-    if(first_hit)
-        uri.addQueryParameter("first_hit", "true");
+std::vector<Terminology::Result> Terminology::resolve(const std::string &name,
+                                                      const std::string &terminology,
+                                                      const std::vector<std::string> &keys,
+                                                      const std::string &match_type,
+                                                      const bool first_hit)
+{
+    std::shared_ptr<TerminologySnapshot> snapshot = TerminologySnapshot::get(Configuration::get<std::string>("terminology.snapshot.path", ""), terminology);
+    if(snapshot && TerminologySnapshot::supports(match_type))
+        return resolveLocally(*snapshot, name, keys, match_type);
+
+    std::vector<Result> results;
+    if(lookupCache(name, terminology, keys, match_type, first_hit, results))
+        return results;
+
+    HttpClient::Request request(getSearchUrl(name, terminology, match_type, first_hit));
+    request.timeout = Configuration::get<int>("terminology.timeout", 5000);
+
+    // the request counts towards the limit of concurrent requests of all queries
+    AdaptiveLimiter &limiter = getLimiter();
+    if(!limiter.acquire(true))
+        throw std::runtime_error("Terminology: the terminology server is unavailable, retry later");
+
+    // the requests of a thread reuse its keep-alive connection
+    auto started = std::chrono::steady_clock::now();
+    HttpClient::Response response;
+    bool request_failed = false;
+    try {
+        response = HttpClient::perform(request);
+    } catch(const std::exception&) {
+        request_failed = true;
+    }
+    limiter.release();
+    long latency = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
 
-    Poco::Net::HTTPSClientSession session(uri.getHost(), uri.getPort(), context);
-    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, uri.getPathAndQuery(), Poco::Net::HTTPRequest::HTTP_1_1);
-    Poco::Net::HTTPResponse response;
+    bool success = resolveResponse(request_failed, response.status, response.body, name, terminology, keys, match_type, first_hit, results);
+    limiter.onFinished(latency, success);
 
-    session.sendRequest(request);
-    std::istream& respStream = session.receiveResponse(response);
-    Json::Value response_json;
+    if(!success && !limiter.isAvailable())
+        throw std::runtime_error("Terminology: the terminology server is unavailable, retry later");
+    return results;
+}
 
-    if (response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
-    {
-        respStream >> response_json;
-    } else {
-        response_json = Json::Value::null;
+bool Terminology::lookupCache(const std::string &name,
+                              const std::string &terminology,
+                              const std::vector<std::string> &keys,
+                              const std::string &match_type,
+                              const bool first_hit,
+                              std::vector<Result> &results)
+{
+    TermCache &cache = TermCache::getInstance();
+    results.resize(keys.size());
+    for(size_t k = 0; k < keys.size(); k++){
+        if(!cache.get(TermCache::Key {terminology, name, keys[k], match_type, first_hit}, results[k].resolved, results[k].value))
+            return false;
     }
+    return true;
+}
 
-    std::string not_resolved = (on_not_resolvable == HandleNotResolvable::EMPTY) ? "" : name;
+std::vector<Terminology::Result> Terminology::storeResults(const Json::Value &response_json,
+                                                          const std::string &name,
+                                                          const std::string &terminology,
+                                                          const std::vector<std::string> &keys,
+                                                          const std::string &match_type,
+                                                          const bool first_hit)
+{
+    TermCache &cache = TermCache::getInstance();
+    std::vector<Result> results(keys.size());
+    for(size_t k = 0; k < keys.size(); k++){
+        results[k].resolved = extractResult(response_json, keys[k], results[k].value);
+
+        // failed requests are not cached, only terms the terminology does not know
+        if(!response_json.isNull())
+            cache.put(TermCache::Key {terminology, name, keys[k], match_type, first_hit}, results[k].resolved, results[k].value);
+    }
+    return results;
+}
 
-    if (response_json.isNull())
-    {
-        return std::make_pair(std::make_pair(name, not_resolved), session.sslSession());
-    } else
-    {
-        Json::Value results = response_json["results"];
-        if(results.empty())
-            return std::make_pair(std::make_pair(name, not_resolved), session.sslSession());
-
-        Json::Value val = results[0].get(key, not_resolved);
-        if(val.isArray()){
-            if(val.empty())
-                return std::make_pair(std::make_pair(name, not_resolved), session.sslSession());
-            else
-                return std::make_pair(std::make_pair(name, val[0].asString()), session.sslSession());
-        }
-        else {
-            return std::make_pair(std::make_pair(name, val.asString()), session.sslSession());
-        }
+std::vector<Terminology::Result> Terminology::resolveLocally(const TerminologySnapshot &snapshot,
+                                                            const std::string &name,
+                                                            const std::vector<std::string> &keys,
+                                                            const std::string &match_type)
+{
+    Json::Value response_json(Json::objectValue);
+    Json::Value term;
+    if(snapshot.search(name, match_type, term))
+        response_json["results"].append(term);
+
+    std::vector<Result> results(keys.size());
+    for(size_t k = 0; k < keys.size(); k++){
+        results[k].resolved = extractResult(response_json, keys[k], results[k].value);
     }
+    return results;
+}
+
+std::string Terminology::notResolved(const std::string &name, const HandleNotResolvable on_not_resolvable)
+{
+    return (on_not_resolvable == HandleNotResolvable::EMPTY) ? "" : name;
 }
 
 std::string Terminology::resolveSingle(const std::string &name,
@@ -223,48 +311,6 @@ std::string Terminology::resolveSingle(const std::string &name,
                                        const bool first_hit,
                                        const HandleNotResolvable onNotResolvable)
 {
-    std::string uri_string = Configuration::get<std::string>("terminology.url_search");
-    Poco::URI uri(uri_string);
-    uri.addQueryParameter("query", name);
-    uri.addQueryParameter("terminologies", terminology);
-    uri.addQueryParameter("match_type", match_type);
-    if(first_hit)
-        uri.addQueryParameter("first_hit", "true");
-
-    Poco::Net::HTTPSClientSession session(uri.getHost(), uri.getPort());
-    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, uri.getPathAndQuery(), Poco::Net::HTTPRequest::HTTP_1_1);
-    Poco::Net::HTTPResponse response;
-
-    session.sendRequest(request);
-    std::istream& respStream = session.receiveResponse(response);
-
-    Json::Value response_json;
-    if (response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
-    {
-        respStream >> response_json;
-    } else {
-        response_json = Json::Value::null;
-    }
-
-    std::string not_resolved = (onNotResolvable == HandleNotResolvable::EMPTY) ? "" : name;
-    if (response_json.isNull())
-    {
-        return not_resolved;
-    } else
-    {
-        Json::Value results = response_json["results"];
-        if(results.empty())
-            return not_resolved;
-
-        Json::Value val = results[0].get(key, not_resolved);
-        if(val.isArray()){
-            if(val.empty())
-                return not_resolved;
-            else
-                return val[0].asString();
-        }
-        else {
-            return val.asString();
-        }
-    }
+    Result result = resolve(name, terminology, std::vector<std::string> {key}, match_type, first_hit)[0];
+    return result.resolved ? result.value : notResolved(name, onNotResolvable);
 }
@@ -3,13 +3,13 @@
 #define MAPPING_CORE_TERMINOLOGY_H
 
 #include <string>
+#include <vector>
 #include <json/json.h>
-#include <Poco/URI.h>
-#include <Poco/Net/HTTPSClientSession.h>
-#include <Poco/Net/HTTPRequest.h>
-#include <Poco/Net/HTTPResponse.h>
 #include "datatypes/simplefeaturecollection.h"
 
+class TerminologySnapshot;
+class AdaptiveLimiter;
+
 enum class HandleNotResolvable {
     EMPTY,
     KEEP
@@ -53,26 +53,132 @@ class Terminology {
                                                         const bool first_hit,
                                                         const HandleNotResolvable on_not_resolvable);
 
+        /**
+         * Resolve a vector of strings for several keys, using one search request per distinct string.
+         * @param names_in vector of strings to be resolved
+         * @param terminology name of the terminology used
+         * @param keys the fields in the result json from terminologies taken as results
+         * @param match_type parameter for terminology search api
+         * @param first_hit parameter for terminology search api
+         * @param on_not_resolvable how to handle a not resolvable string: EMPTY or OLD_NAME
+         * @return a vector of resolved terms for every key, order of names_in preserved.
+         */
+        static std::vector<std::vector<std::string>> resolveMultipleKeys(const std::vector<std::string> &names_in,
+                                                                         const std::string &terminology,
+                                                                         const std::vector<std::string> &keys,
+                                                                         const std::string &match_type,
+                                                                         const bool first_hit,
+                                                                         const HandleNotResolvable on_not_resolvable);
+
+        /**
+         * Resolve distinct strings for several keys, e.g. the values of a dictionary encoded attribute.
+         * @param distinct_names strings to be resolved, each one is searched once
+         * @param terminology name of the terminology used
+         * @param keys the fields in the result json from terminologies taken as results
+         * @param match_type parameter for terminology search api
+         * @param first_hit parameter for terminology search api
+         * @param on_not_resolvable how to handle a not resolvable string: EMPTY or OLD_NAME
+         * @return a vector of resolved terms for every key, order of distinct_names preserved.
+         */
+        static std::vector<std::vector<std::string>> resolveDistinct(const std::vector<std::string> &distinct_names,
+                                                                     const std::string &terminology,
+                                                                     const std::vector<std::string> &keys,
+                                                                     const std::string &match_type,
+                                                                     const bool first_hit,
+                                                                     const HandleNotResolvable on_not_resolvable);
+
     private:
-        using string_pair = std::pair<std::string, std::string>;
-        using string_session_ptr_pair = std::pair<Terminology::string_pair, Poco::Net::Session::Ptr>;
-
-        static string_session_ptr_pair resolveSingleNameSetSessionPtr(Poco::Net::Context::Ptr &context,
-                                                                      const std::string &name,
-                                                                      const std::string &terminology,
-                                                                      const std::string &key,
-                                                                      const std::string &match_type,
-                                                                      const bool first_hit,
-                                                                      const HandleNotResolvable on_not_resolvable);
-
-        static string_pair resolveSingleNameInternal(Poco::Net::Context::Ptr &context,
-                                                     Poco::Net::Session::Ptr &session_ptr,
-                                                     const std::string &name,
-                                                     const std::string &terminology,
-                                                     const std::string &key,
-                                                     const std::string &match_type,
-                                                     const bool first_hit,
-                                                     const HandleNotResolvable &on_not_resolvable);
+        /**
+         * Resolution of a string for one key.
+         */
+        struct Result {
+            bool resolved;
+            std::string value;
+        };
+
+        /**
+         * Concurrency control and circuit breaker for the requests to the terminology server,
+         * shared by all queries of the process.
+         */
+        static AdaptiveLimiter &getLimiter();
+
+        /**
+         * @return true if the terminology server is overloaded, such responses are not cached
+         */
+        static bool isOverloaded(const long status);
+
+        /**
+         * Take the results of a search request. Terms of failed requests and malformed responses are not resolved.
+         * @return false if the request failed or its response could not be parsed
+         */
+        static bool resolveResponse(const bool request_failed,
+                                    const long status,
+                                    const std::string &body,
+                                    const std::string &name,
+                                    const std::string &terminology,
+                                    const std::vector<std::string> &keys,
+                                    const std::string &match_type,
+                                    const bool first_hit,
+                                    std::vector<Result> &results);
+
+        static std::string getSearchUrl(const std::string &name,
+                                        const std::string &terminology,
+                                        const std::string &match_type,
+                                        const bool first_hit);
+
+        /**
+         * @param response_json set to the response json, null if the request was not successful
+         * @return false if the body of a successful request is malformed
+         */
+        static bool parseResponse(const long status, const std::string &body, Json::Value &response_json);
+
+        /**
+         * Take the value of the key from the first result of a search response.
+         * @return false if the term could not be resolved
+         */
+        static bool extractResult(const Json::Value &response_json,
+                                  const std::string &key,
+                                  std::string &result);
+
+        /**
+         * Resolve a single string for all keys, using a local snapshot or the term cache if possible.
+         */
+        static std::vector<Result> resolve(const std::string &name,
+                                           const std::string &terminology,
+                                           const std::vector<std::string> &keys,
+                                           const std::string &match_type,
+                                           const bool first_hit);
+
+        /**
+         * Look up a single string for all keys in the term cache.
+         * @return false if one of the keys is not cached
+         */
+        static bool lookupCache(const std::string &name,
+                                const std::string &terminology,
+                                const std::vector<std::string> &keys,
+                                const std::string &match_type,
+                                const bool first_hit,
+                                std::vector<Result> &results);
+
+        /**
+         * Take the results for all keys from a search response and store them in the term cache.
+         */
+        static std::vector<Result> storeResults(const Json::Value &response_json,
+                                                const std::string &name,
+                                                const std::string &terminology,
+                                                const std::vector<std::string> &keys,
+                                                const std::string &match_type,
+                                                const bool first_hit);
+
+        /**
+         * Resolve a single string for all keys from a local snapshot of the terminology.
+         */
+        static std::vector<Result> resolveLocally(const TerminologySnapshot &snapshot,
+                                                  const std::string &name,
+                                                  const std::vector<std::string> &keys,
+                                                  const std::string &match_type);
+
+        static std::string notResolved(const std::string &name, const HandleNotResolvable on_not_resolvable);
 };
 
 #endif //MAPPING_CORE_TERMINOLOGY_H
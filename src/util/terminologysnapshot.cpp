@@ -0,0 +1,544 @@
+#include "terminologysnapshot.h"
+
+#include "util/concat.h"
+#include "util/exceptions.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * File layout, all sections are aligned to 8 bytes:
+ * - header
+ * - recordCount + 1 offsets of the terms' JSON in the strings
+ * - names, ordered by record
+ * - hash table of tableSize slots, each 0 or the index of a name + 1
+ * - trigrams, ordered by key
+ * - postings: the indices of the names containing a trigram, in ascending order
+ * - strings: the JSON of all terms followed by the lower case names
+ */
+struct TerminologySnapshot::Header {
+	char magic[8];
+	uint64_t recordCount;
+	uint64_t nameCount;
+	uint64_t tableSize;
+	uint64_t trigramCount;
+	uint64_t postingCount;
+	uint64_t stringsSize;
+};
+
+struct TerminologySnapshot::Name {
+	uint64_t offset;
+	uint32_t length;
+	uint32_t record;
+};
+
+struct TerminologySnapshot::Trigram {
+	uint32_t key;
+	uint32_t count;
+	uint64_t begin;
+};
+
+static const char snapshotMagic[8] = {'T', 'R', 'M', 'S', 'N', 'A', 'P', '1'};
+
+/**
+ * the fields of a term whose values are searched
+ */
+static const char *nameFields[] = {"label", "synonyms", "commonNames"};
+
+static size_t align(size_t size) {
+	return (size + 7) / 8 * 8;
+}
+
+static std::string toLower(const std::string &value) {
+	std::string lower(value);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	});
+	return lower;
+}
+
+static uint64_t hashName(const char *name, size_t length) {
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for(size_t i = 0; i < length; ++i) {
+		hash ^= static_cast<unsigned char>(name[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static uint32_t trigramKey(const char *position) {
+	return static_cast<uint32_t>(static_cast<unsigned char>(position[0])) << 16
+		   | static_cast<uint32_t>(static_cast<unsigned char>(position[1])) << 8
+		   | static_cast<uint32_t>(static_cast<unsigned char>(position[2]));
+}
+
+static std::vector<uint32_t> getTrigrams(const std::string &name) {
+	std::vector<uint32_t> keys;
+	for(size_t i = 0; i + 3 <= name.size(); ++i) {
+		keys.push_back(trigramKey(name.data() + i));
+	}
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	return keys;
+}
+
+TerminologySnapshot::TerminologySnapshot(std::unique_ptr<MappedFile> file)
+		: file(std::move(file)), data(this->file->getData()), size(this->file->getSize()),
+		  header(reinterpret_cast<const Header*>(data)), records(nullptr), names(nullptr), table(nullptr),
+		  trigrams(nullptr), postings(nullptr), strings(nullptr) {
+}
+
+std::shared_ptr<TerminologySnapshot> TerminologySnapshot::get(const std::string &directory, const std::string &terminology) {
+	/**
+	 * an opened snapshot file, identified by inode and modification time, so a snapshot
+	 * replaced by a new import is opened again
+	 */
+	struct Entry {
+		ino_t inode;
+		time_t modified;
+		std::shared_ptr<TerminologySnapshot> snapshot;
+	};
+	static std::mutex mutex;
+	static std::map<std::string, Entry> snapshots;
+
+	if(directory.empty()) {
+		return nullptr;
+	}
+
+	std::string path = concat(directory, "/", terminology, ".snapshot");
+	struct stat status;
+	if(stat(path.c_str(), &status) != 0) {
+		std::lock_guard<std::mutex> lock(mutex);
+		snapshots.erase(terminology);
+		return nullptr;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = snapshots.find(terminology);
+		if(it != snapshots.end() && it->second.inode == status.st_ino && it->second.modified == status.st_mtime) {
+			return it->second.snapshot;
+		}
+	}
+
+	// opened without holding the lock, as checking a large snapshot takes a while
+	std::shared_ptr<TerminologySnapshot> snapshot = open(path);
+	std::lock_guard<std::mutex> lock(mutex);
+	snapshots[terminology] = Entry {status.st_ino, status.st_mtime, snapshot};
+	return snapshot;
+}
+
+std::unique_ptr<TerminologySnapshot> TerminologySnapshot::open(const std::string &path) {
+	std::unique_ptr<MappedFile> mapped = MappedFile::open(path);
+	if(!mapped) {
+		return nullptr;
+	}
+
+	std::unique_ptr<TerminologySnapshot> snapshot(new TerminologySnapshot(std::move(mapped)));
+	if(!snapshot->initialize()) {
+		return nullptr;
+	}
+	return snapshot;
+}
+
+bool TerminologySnapshot::initialize() {
+	if(size < sizeof(Header) || std::memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) != 0) {
+		return false;
+	}
+
+	const uint64_t maxCount = std::numeric_limits<uint32_t>::max();
+	if(header->recordCount > maxCount || header->nameCount > maxCount || header->tableSize > maxCount
+	   || header->trigramCount > maxCount || header->postingCount > maxCount || header->stringsSize > size
+	   || (header->tableSize & (header->tableSize - 1)) != 0 || header->tableSize <= header->nameCount) {
+		return false;
+	}
+
+	size_t offset = sizeof(Header);
+	size_t recordsOffset = offset;
+	offset += align((header->recordCount + 1) * sizeof(uint64_t));
+	size_t namesOffset = offset;
+	offset += align(header->nameCount * sizeof(Name));
+	size_t tableOffset = offset;
+	offset += align(header->tableSize * sizeof(uint32_t));
+	size_t trigramsOffset = offset;
+	offset += align(header->trigramCount * sizeof(Trigram));
+	size_t postingsOffset = offset;
+	offset += align(header->postingCount * sizeof(uint32_t));
+	size_t stringsOffset = offset;
+	offset += header->stringsSize;
+	if(offset > size) {
+		return false;
+	}
+
+	records = reinterpret_cast<const uint64_t*>(data + recordsOffset);
+	names = reinterpret_cast<const Name*>(data + namesOffset);
+	table = reinterpret_cast<const uint32_t*>(data + tableOffset);
+	trigrams = reinterpret_cast<const Trigram*>(data + trigramsOffset);
+	postings = reinterpret_cast<const uint32_t*>(data + postingsOffset);
+	strings = data + stringsOffset;
+
+	if(records[header->recordCount] > header->stringsSize) {
+		return false;
+	}
+	for(uint64_t i = 0; i < header->nameCount; ++i) {
+		if(names[i].record >= header->recordCount || names[i].offset + names[i].length > header->stringsSize) {
+			return false;
+		}
+	}
+	for(uint64_t i = 0; i < header->trigramCount; ++i) {
+		if(trigrams[i].begin + trigrams[i].count > header->postingCount) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void TerminologySnapshot::import(const std::string &dumpPath, const std::string &snapshotPath) {
+	std::ifstream dump(dumpPath);
+	if(!dump.is_open()) {
+		throw std::runtime_error(concat("TerminologySnapshot: could not open ", dumpPath));
+	}
+
+	std::string recordData;
+	std::vector<uint64_t> recordOffsets(1, 0);
+	std::string nameData;
+	std::vector<Name> nameEntries;
+
+	Json::Reader reader(Json::Features::strictMode());
+	Json::FastWriter writer;
+	std::string line;
+	size_t lineNumber = 0;
+	while(std::getline(dump, line)) {
+		++lineNumber;
+		if(line.find_first_not_of(" \t\r") == std::string::npos) {
+			continue;
+		}
+
+		Json::Value term;
+		if(!reader.parse(line, term) || !term.isObject()) {
+			throw std::runtime_error(concat("TerminologySnapshot: invalid term in line ", lineNumber, " of ", dumpPath));
+		}
+		if(recordOffsets.size() > std::numeric_limits<uint32_t>::max()) {
+			throw std::runtime_error(concat("TerminologySnapshot: too many terms in ", dumpPath));
+		}
+		uint32_t record = static_cast<uint32_t>(recordOffsets.size() - 1);
+
+		std::set<std::string> termNames;
+		for(const char *field : nameFields) {
+			const Json::Value &value = term[field];
+			if(value.isString()) {
+				termNames.insert(toLower(value.asString()));
+			} else if(value.isArray()) {
+				for(auto &element : value) {
+					if(element.isString()) {
+						termNames.insert(toLower(element.asString()));
+					}
+				}
+			}
+		}
+
+		for(auto &name : termNames) {
+			if(!name.empty() && name.size() <= std::numeric_limits<uint32_t>::max()) {
+				nameEntries.push_back(Name {nameData.size(), static_cast<uint32_t>(name.size()), record});
+				nameData += name;
+			}
+		}
+
+		recordData += writer.write(term);
+		recordOffsets.push_back(recordData.size());
+	}
+
+	// names are stored after the terms
+	for(auto &name : nameEntries) {
+		name.offset += recordData.size();
+	}
+	std::string strings = recordData + nameData;
+	recordData.clear();
+	nameData.clear();
+
+	uint64_t tableSize = 16;
+	while(tableSize < nameEntries.size() * 2) {
+		tableSize *= 2;
+	}
+	std::vector<uint32_t> table(tableSize, 0);
+	std::unordered_map<uint32_t, std::vector<uint32_t>> trigramPostings;
+	for(size_t i = 0; i < nameEntries.size(); ++i) {
+		const Name &name = nameEntries[i];
+		const char *nameBegin = strings.data() + name.offset;
+
+		// linear probing keeps equal names in the order of their terms
+		uint64_t slot = hashName(nameBegin, name.length) & (tableSize - 1);
+		while(table[slot] != 0) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		table[slot] = static_cast<uint32_t>(i + 1);
+
+		for(uint32_t key : getTrigrams(std::string(nameBegin, name.length))) {
+			trigramPostings[key].push_back(static_cast<uint32_t>(i));
+		}
+	}
+
+	std::vector<uint32_t> trigramKeys;
+	trigramKeys.reserve(trigramPostings.size());
+	for(auto &entry : trigramPostings) {
+		trigramKeys.push_back(entry.first);
+	}
+	std::sort(trigramKeys.begin(), trigramKeys.end());
+
+	std::vector<Trigram> trigramEntries;
+	std::vector<uint32_t> postingData;
+	for(uint32_t key : trigramKeys) {
+		std::vector<uint32_t> &posting = trigramPostings[key];
+		trigramEntries.push_back(Trigram {key, static_cast<uint32_t>(posting.size()), postingData.size()});
+		postingData.insert(postingData.end(), posting.begin(), posting.end());
+		std::vector<uint32_t>().swap(posting);
+	}
+
+	Header header;
+	std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+	header.recordCount = recordOffsets.size() - 1;
+	header.nameCount = nameEntries.size();
+	header.tableSize = tableSize;
+	header.trigramCount = trigramEntries.size();
+	header.postingCount = postingData.size();
+	header.stringsSize = strings.size();
+
+	// written to a temporary file first, so other processes never open a partial snapshot
+	std::string temporaryPath = concat(snapshotPath, ".tmp.", getpid());
+	std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+	auto writeSection = [&output](const void *section, size_t sectionSize) {
+		static const char zeros[8] = {0};
+		output.write(static_cast<const char*>(section), sectionSize);
+		output.write(zeros, align(sectionSize) - sectionSize);
+	};
+	writeSection(&header, sizeof(header));
+	writeSection(recordOffsets.data(), recordOffsets.size() * sizeof(uint64_t));
+	writeSection(nameEntries.data(), nameEntries.size() * sizeof(Name));
+	writeSection(table.data(), table.size() * sizeof(uint32_t));
+	writeSection(trigramEntries.data(), trigramEntries.size() * sizeof(Trigram));
+	writeSection(postingData.data(), postingData.size() * sizeof(uint32_t));
+	output.write(strings.data(), strings.size());
+	output.close();
+
+	if(output.fail() || std::rename(temporaryPath.c_str(), snapshotPath.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+		throw std::runtime_error(concat("TerminologySnapshot: could not write ", snapshotPath));
+	}
+}
+
+bool TerminologySnapshot::supports(const std::string &matchType) {
+	return matchType == "exact" || matchType == "included" || matchType == "regex";
+}
+
+bool TerminologySnapshot::search(const std::string &query, const std::string &matchType, Json::Value &term) const {
+	uint64_t name;
+	if(matchType == "exact") {
+		name = findExact(toLower(query));
+	} else if(matchType == "included") {
+		name = findIncluded(toLower(query));
+	} else if(matchType == "regex") {
+		name = findRegex(query);
+	} else {
+		throw ArgumentException(concat("TerminologySnapshot: unsupported match type ", matchType));
+	}
+
+	if(name >= header->nameCount) {
+		return false;
+	}
+
+	uint32_t record = names[name].record;
+	const char *begin = strings + records[record];
+	const char *end = strings + records[record + 1];
+	Json::Reader reader(Json::Features::strictMode());
+	return reader.parse(begin, end, term, false);
+}
+
+uint64_t TerminologySnapshot::findExact(const std::string &query) const {
+	uint64_t mask = header->tableSize - 1;
+	for(uint64_t slot = hashName(query.data(), query.size()) & mask; table[slot] != 0; slot = (slot + 1) & mask) {
+		uint64_t name = table[slot] - 1;
+		if(names[name].length == query.size() && std::memcmp(strings + names[name].offset, query.data(), query.size()) == 0) {
+			return name;
+		}
+	}
+	return header->nameCount;
+}
+
+const TerminologySnapshot::Trigram *TerminologySnapshot::findRarestTrigram(const std::string &text) const {
+	const Trigram *rarest = nullptr;
+	const Trigram *trigramsEnd = trigrams + header->trigramCount;
+	for(uint32_t key : getTrigrams(text)) {
+		const Trigram *trigram = std::lower_bound(trigrams, trigramsEnd, key, [](const Trigram &entry, uint32_t value) {
+			return entry.key < value;
+		});
+		if(trigram == trigramsEnd || trigram->key != key) {
+			return nullptr;
+		}
+		if(rarest == nullptr || trigram->count < rarest->count) {
+			rarest = trigram;
+		}
+	}
+	return rarest;
+}
+
+uint64_t TerminologySnapshot::findIncluded(const std::string &query) const {
+	auto contains = [this, &query](uint64_t name) {
+		const char *begin = strings + names[name].offset;
+		const char *end = begin + names[name].length;
+		return std::search(begin, end, query.begin(), query.end()) != end;
+	};
+
+	if(query.size() < 3) {
+		for(uint64_t name = 0; name < header->nameCount; ++name) {
+			if(contains(name)) {
+				return name;
+			}
+		}
+		return header->nameCount;
+	}
+
+	// every matching name contains all trigrams of the query, so the rarest one limits the candidates
+	const Trigram *rarest = findRarestTrigram(query);
+	if(rarest == nullptr) {
+		return header->nameCount;
+	}
+
+	for(uint64_t i = 0; i < rarest->count; ++i) {
+		uint64_t name = postings[rarest->begin + i];
+		if(contains(name)) {
+			return name;
+		}
+	}
+	return header->nameCount;
+}
+
+std::string TerminologySnapshot::getRequiredLiteral(const std::string &pattern) {
+	std::string longest;
+	std::string literal;
+	auto endLiteral = [&]() {
+		if(literal.size() > longest.size()) {
+			longest = literal;
+		}
+		literal.clear();
+	};
+
+	// only literals outside of groups are required, and none at all with an alternative on the top level
+	int depth = 0;
+	for(size_t i = 0; i < pattern.size(); ++i) {
+		char c = pattern[i];
+		if(c == '\\') {
+			if(i + 1 == pattern.size()) {
+				return "";
+			}
+			char escaped = pattern[++i];
+			if(!std::isalnum(static_cast<unsigned char>(escaped))) {
+				if(depth == 0) {
+					literal += escaped;
+				}
+			} else if(std::strchr("dDwWsSbB", escaped) != nullptr) {
+				endLiteral();
+			} else {
+				// escapes like \x41 or backreferences are not worth interpreting
+				return "";
+			}
+		} else if(c == '[') {
+			// skip the character class, a ] right after the opening bracket belongs to the class
+			endLiteral();
+			size_t j = i + 1;
+			if(j < pattern.size() && pattern[j] == '^') {
+				++j;
+			}
+			if(j < pattern.size() && pattern[j] == ']') {
+				++j;
+			}
+			for(; j < pattern.size() && pattern[j] != ']'; ++j) {
+				if(pattern[j] == '\\') {
+					++j;
+				}
+			}
+			i = j;
+		} else if(c == '(') {
+			endLiteral();
+			++depth;
+		} else if(c == ')') {
+			endLiteral();
+			--depth;
+		} else if(c == '|') {
+			if(depth == 0) {
+				return "";
+			}
+		} else if(c == '*' || c == '?' || c == '{') {
+			// the preceding character may be missing
+			if(!literal.empty()) {
+				literal.pop_back();
+			}
+			endLiteral();
+			if(c == '{') {
+				// skip the bounds of the quantifier
+				size_t closing = pattern.find('}', i);
+				if(closing == std::string::npos) {
+					return "";
+				}
+				i = closing;
+			}
+		} else if(c == '+' || c == '.' || c == '^' || c == '$') {
+			endLiteral();
+		} else if(depth == 0) {
+			literal += c;
+		}
+	}
+	endLiteral();
+	return longest;
+}
+
+uint64_t TerminologySnapshot::findRegex(const std::string &query) const {
+	std::regex expression;
+	try {
+		expression = std::regex(query, std::regex::ECMAScript | std::regex::icase | std::regex::optimize);
+	} catch (const std::regex_error&) {
+		throw ArgumentException(concat("TerminologySnapshot: invalid regular expression ", query));
+	}
+
+	auto matches = [this, &expression](uint64_t name) {
+		const char *begin = strings + names[name].offset;
+		return std::regex_search(begin, begin + names[name].length, expression);
+	};
+
+	// a literal that every match contains limits the candidates like for included matches
+	std::string literal = toLower(getRequiredLiteral(query));
+	if(literal.size() < 3) {
+		for(uint64_t name = 0; name < header->nameCount; ++name) {
+			if(matches(name)) {
+				return name;
+			}
+		}
+		return header->nameCount;
+	}
+
+	const Trigram *rarest = findRarestTrigram(literal);
+	if(rarest == nullptr) {
+		return header->nameCount;
+	}
+
+	for(uint64_t i = 0; i < rarest->count; ++i) {
+		uint64_t name = postings[rarest->begin + i];
+		if(matches(name)) {
+			return name;
+		}
+	}
+	return header->nameCount;
+}
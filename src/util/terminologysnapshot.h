@@ -0,0 +1,101 @@
+#ifndef UTIL_TERMINOLOGYSNAPSHOT_H_
+#define UTIL_TERMINOLOGYSNAPSHOT_H_
+
+#include "util/mappedfile.h"
+
+#include <json/json.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * Local, memory mapped copy of a terminology for resolving terms without requests
+ * to the terminology server.
+ *
+ * A snapshot is imported offline with `mapping_gfbio_terminology_import` from a dump with
+ * one term per line, each a JSON object as in the results of the search api. The label,
+ * synonyms and common names of the terms are indexed case insensitively: a hash table for
+ * `exact` matches and a trigram index for `included` matches. `regex` matches use the
+ * trigram index for the longest literal that every match must contain and scan all names
+ * if the pattern has none. If several terms match, the first one of the dump is returned.
+ */
+class TerminologySnapshot {
+public:
+	TerminologySnapshot(const TerminologySnapshot&) = delete;
+	TerminologySnapshot &operator=(const TerminologySnapshot&) = delete;
+
+	/**
+	 * get the snapshot `<terminology>.snapshot` from the directory. Opened snapshots are kept
+	 * until the file is replaced.
+	 * @return the snapshot or nullptr if there is no valid one for the terminology
+	 */
+	static std::shared_ptr<TerminologySnapshot> get(const std::string &directory, const std::string &terminology);
+
+	/**
+	 * open a snapshot file
+	 * @return the snapshot or nullptr if the file does not exist or is invalid
+	 */
+	static std::unique_ptr<TerminologySnapshot> open(const std::string &path);
+
+	/**
+	 * create a snapshot file from a dump
+	 */
+	static void import(const std::string &dumpPath, const std::string &snapshotPath);
+
+	/**
+	 * @return true if terms can be searched with the match type
+	 */
+	static bool supports(const std::string &matchType);
+
+	/**
+	 * find the first term matching the query
+	 * @param term set to the matching term
+	 * @return false if no term matches
+	 */
+	bool search(const std::string &query, const std::string &matchType, Json::Value &term) const;
+
+private:
+	explicit TerminologySnapshot(std::unique_ptr<MappedFile> file);
+
+	struct Header;
+	struct Name;
+	struct Trigram;
+
+	/**
+	 * check the file and set up the pointers to its sections
+	 * @return false if the file is invalid
+	 */
+	bool initialize();
+
+	/**
+	 * @return the trigram of the text contained in the fewest names, nullptr if no name contains
+	 *         one of the trigrams
+	 */
+	const Trigram *findRarestTrigram(const std::string &text) const;
+
+	/**
+	 * @return the longest literal that every match of the regular expression contains, empty if
+	 *         there is none or the pattern is too complex
+	 */
+	static std::string getRequiredLiteral(const std::string &pattern);
+
+	/**
+	 * @return the index of the first name matching the query, or nameCount if none matches
+	 */
+	uint64_t findExact(const std::string &query) const;
+	uint64_t findIncluded(const std::string &query) const;
+	uint64_t findRegex(const std::string &query) const;
+
+	std::unique_ptr<MappedFile> file;
+	const char *data;
+	size_t size;
+	const Header *header;
+	const uint64_t *records;
+	const Name *names;
+	const uint32_t *table;
+	const Trigram *trigrams;
+	const uint32_t *postings;
+	const char *strings;
+};
+
+#endif /* UTIL_TERMINOLOGYSNAPSHOT_H_ */
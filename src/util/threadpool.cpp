@@ -0,0 +1,20 @@
+#include "threadpool.h"
+
+#include <boost/bind.hpp>
+
+ThreadPool::ThreadPool(size_t size)
+		: work(new boost::asio::io_service::work(io_service)), threadCount(size > 0 ? size : 1) {
+	for(size_t i = 0; i < threadCount; ++i) {
+		threads.create_thread(boost::bind(&boost::asio::io_service::run, &io_service));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	// finish pending tasks, then stop the workers
+	work.reset();
+	threads.join_all();
+}
+
+size_t ThreadPool::size() const {
+	return threadCount;
+}
@@ -0,0 +1,50 @@
+#ifndef UTIL_THREADPOOL_H_
+#define UTIL_THREADPOOL_H_
+
+#include <future>
+#include <memory>
+
+#include <boost/thread.hpp>
+#include <boost/asio.hpp>
+
+/**
+ * Fixed size pool of worker threads executing submitted tasks in FIFO order.
+ *
+ * Tasks must not wait for other tasks of the same pool, as this can deadlock
+ * once all workers are waiting.
+ */
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t size);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool &operator=(const ThreadPool&) = delete;
+
+	/**
+	 * run the function on a worker thread
+	 * @return the future of the function's result
+	 */
+	template<typename Function>
+	auto submit(Function function) -> std::future<decltype(function())> {
+		using Result = decltype(function());
+
+		auto task = std::make_shared<std::packaged_task<Result()>>(function);
+		std::future<Result> future = task->get_future();
+		io_service.post([task]() {
+			(*task)();
+		});
+
+		return future;
+	}
+
+	size_t size() const;
+
+private:
+	boost::asio::io_service io_service;
+	std::unique_ptr<boost::asio::io_service::work> work;
+	boost::thread_group threads;
+	size_t threadCount;
+};
+
+#endif /* UTIL_THREADPOOL_H_ */
@@ -0,0 +1,94 @@
+/**
+ * Benchmark comparing the fast PangaeaTabParser of the pangaea_source ingest path with the
+ * generic CSVSourceUtil it replaces. It is part of the unit tests, but disabled by default:
+ *
+ *   PANGAEA_BENCHMARK_FILE=<pangaea tab file> unittests --gtest_also_run_disabled_tests --gtest_filter='PangaeaTabParserBenchmark.*'
+ *
+ * The x/y columns are the first columns whose names start with "Longitude" and "Latitude",
+ * all other columns are parsed as numeric attributes.
+ */
+
+#include "util/pangaeatabparser.h"
+#include "util/csv_source_util.h"
+#include "util/stringsplit.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+template<typename Function>
+static size_t measure(const std::string &name, size_t bytes, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    size_t features = function();
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << (bytes / seconds / 1e9) << " GB/s (" << features << " features)" << std::endl;
+    return features;
+}
+
+TEST(PangaeaTabParserBenchmark, DISABLED_compareWithCSVSourceUtil){
+    const char *path = std::getenv("PANGAEA_BENCHMARK_FILE");
+    ASSERT_NE(path, nullptr) << "PANGAEA_BENCHMARK_FILE is not set";
+
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    const std::string content = ss.str();
+
+    // skip the data description
+    size_t offset = content.find("*/\n");
+    offset = offset == std::string::npos ? 0 : offset + 3;
+    size_t headerEnd = content.find('\n', offset);
+    ASSERT_NE(headerEnd, std::string::npos);
+
+    std::string header = content.substr(offset, headerEnd - offset);
+    if(!header.empty() && header.back() == '\r') {
+        header.pop_back();
+    }
+    const std::string data = content.substr(headerEnd + 1);
+
+    std::vector<std::string> columnNames = split(header, '\t');
+    Json::Value params(Json::objectValue);
+    params["separator"] = "\t";
+    params["geometry"] = "xy";
+    params["time"] = "none";
+    params["on_error"] = "skip";
+    params["columns"]["numeric"] = Json::Value(Json::arrayValue);
+    for(auto &name : columnNames) {
+        if(!params["columns"].isMember("x") && name.compare(0, 9, "Longitude") == 0) {
+            params["columns"]["x"] = name;
+        } else if(!params["columns"].isMember("y") && name.compare(0, 8, "Latitude") == 0) {
+            params["columns"]["y"] = name;
+        } else {
+            params["columns"]["numeric"].append(name);
+        }
+    }
+    ASSERT_TRUE(PangaeaTabParser::isApplicable(params)) << "no longitude/latitude columns";
+
+    if(PangaeaTabParser::hasQuotes(data.data(), data.data() + data.size())) {
+        std::cout << "the data contains quotes, which are left to CSVSourceUtil by pangaea_source" << std::endl;
+    }
+
+    QueryRectangle rect(SpatialReference::extent(CrsId::wgs84()), TemporalReference::unreferenced(), QueryResolution::none());
+    const std::string csv = header + "\n" + data;
+
+    size_t expected = measure("CSVSourceUtil", data.size(), [&params, &csv, &rect]() {
+        CSVSourceUtil util(params);
+        std::istringstream stream(csv);
+        return util.getPointCollection(stream, rect)->getFeatureCount();
+    });
+
+    size_t features = measure("PangaeaTabParser", data.size(), [&params, &columnNames, &data, &rect]() {
+        PangaeaTabParser parser(columnNames, params);
+        auto points = parser.createCollection(rect);
+        parser.parse(data.data(), data.data() + data.size(), *points);
+        return points->filterBySpatioTemporalReferenceIntersection(rect)->getFeatureCount();
+    });
+
+    EXPECT_EQ(features, expected);
+}
@@ -0,0 +1,89 @@
+#include "util/adaptivelimiter.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(AdaptiveLimiter, increasesWhileFast){
+    AdaptiveLimiter limiter(16, 0, 0, 30);
+    EXPECT_EQ(limiter.getLimit(), 4);
+
+    for(int i = 0; i < 100; i++)
+        limiter.onFinished(20, true);
+
+    EXPECT_EQ(limiter.getLimit(), 16);
+    EXPECT_EQ(limiter.getHedgeDelay(), 0);
+}
+
+TEST(AdaptiveLimiter, decreasesOnFailures){
+    AdaptiveLimiter limiter(64, 0, 0, 30);
+    for(int i = 0; i < 60; i++)
+        limiter.onFinished(20, true);
+    EXPECT_EQ(limiter.getLimit(), 64);
+
+    limiter.onFinished(20, false);
+    EXPECT_EQ(limiter.getLimit(), 32);
+
+    // grows slowly after the first decrease
+    for(int i = 0; i < 32; i++)
+        limiter.onFinished(20, true);
+    EXPECT_EQ(limiter.getLimit(), 32);
+}
+
+TEST(AdaptiveLimiter, decreasesOnHighLatency){
+    AdaptiveLimiter limiter(64, 0, 0, 30);
+    for(int i = 0; i < 60; i++)
+        limiter.onFinished(20, true);
+
+    limiter.onFinished(500, true);
+    EXPECT_LT(limiter.getLimit(), 64);
+    EXPECT_GE(limiter.getLimit(), 57);
+}
+
+TEST(AdaptiveLimiter, hedgesAfterPercentile){
+    AdaptiveLimiter limiter(64, 90, 0, 30);
+    for(int i = 1; i <= 100; i++)
+        limiter.onFinished(i, true);
+
+    EXPECT_EQ(limiter.getHedgeDelay(), 90);
+}
+
+TEST(AdaptiveLimiter, opensCircuit){
+    AdaptiveLimiter limiter(64, 0, 3, 0);
+    limiter.onFinished(20, false);
+    limiter.onFinished(20, false);
+    EXPECT_TRUE(limiter.isAvailable());
+    EXPECT_GE(limiter.getLimit(), 1);
+
+    // without cool down, the circuit is half open right away and allows a single request
+    limiter.onFinished(20, false);
+    EXPECT_TRUE(limiter.isAvailable());
+    EXPECT_EQ(limiter.getLimit(), 1);
+
+    limiter.onFinished(20, true);
+    EXPECT_GT(limiter.getLimit(), 1);
+
+    AdaptiveLimiter open(64, 0, 1, 30);
+    open.onFinished(20, false);
+    EXPECT_FALSE(open.isAvailable());
+    EXPECT_EQ(open.getLimit(), 0);
+}
+
+TEST(AdaptiveLimiter, limitsAcquiredSlots){
+    AdaptiveLimiter limiter(64, 0, 1, 30);
+    EXPECT_EQ(limiter.getLimit(), 4);
+
+    // the slots are shared by all callers
+    for(int i = 0; i < 4; i++)
+        EXPECT_TRUE(limiter.acquire(false));
+    EXPECT_FALSE(limiter.acquire(false));
+
+    limiter.release();
+    EXPECT_TRUE(limiter.acquire(false));
+
+    // an open circuit fails waiting callers
+    std::thread waiting([&limiter]() {
+        EXPECT_FALSE(limiter.acquire(true));
+    });
+    limiter.onFinished(20, false);
+    waiting.join();
+    EXPECT_FALSE(limiter.acquire(true));
+}
@@ -0,0 +1,66 @@
+#include "util/jsonextractor.h"
+#include <gtest/gtest.h>
+
+TEST(JsonExtractor, extractsPaths){
+    std::string json = R"({
+        "request": {"query": "plum", "terminologies": ["NCBITAXON"]},
+        "results": [
+            {"label": "Prunus domestica", "synonyms": ["plum", "European plum"], "uri": "http://purl.obolibrary.org/obo/NCBITaxon_3758"},
+            {"label": "Prunus", "uri": "http://purl.obolibrary.org/obo/NCBITaxon_3754"}
+        ],
+        "diagnostics": {"time": 12}
+    })";
+
+    JsonExtractor extractor({"results.0", "request.query"});
+    Json::Value document;
+    ASSERT_TRUE(extractor.extract(json, document));
+
+    EXPECT_EQ(document["results"].size(), 1);
+    EXPECT_EQ(document["results"][0]["label"].asString(), "Prunus domestica");
+    EXPECT_EQ(document["results"][0]["synonyms"][1].asString(), "European plum");
+    EXPECT_EQ(document["request"]["query"].asString(), "plum");
+    EXPECT_FALSE(document["request"].isMember("terminologies"));
+    EXPECT_FALSE(document.isMember("diagnostics"));
+}
+
+TEST(JsonExtractor, missingPaths){
+    JsonExtractor extractor({"results.0", "name"});
+    Json::Value document;
+
+    ASSERT_TRUE(extractor.extract(R"({"results": [], "other": {"name": "x"}})", document));
+    EXPECT_TRUE(document["results"].isArray());
+    EXPECT_TRUE(document["results"].empty());
+    EXPECT_FALSE(document.isMember("name"));
+
+    ASSERT_TRUE(extractor.extract("[1, 2]", document));
+    EXPECT_TRUE(document.isArray());
+}
+
+TEST(JsonExtractor, skipsStringsAndEscapes){
+    JsonExtractor extractor({"a\"b", "c"});
+    Json::Value document;
+
+    ASSERT_TRUE(extractor.extract(R"({"x": "}]\"{[", "y": [{"z": "]"}], "a\"b": 1.5e3, "c": [true, null, "ä"]})", document));
+    EXPECT_EQ(document["a\"b"].asDouble(), 1500);
+    EXPECT_TRUE(document["c"][0].asBool());
+    EXPECT_EQ(document["c"][2].asString(), "\xc3\xa4");
+}
+
+TEST(JsonExtractor, stopsEarly){
+    JsonExtractor extractor({"results.0"});
+    Json::Value document;
+
+    // the document is not read beyond the first result
+    ASSERT_TRUE(extractor.extract(R"({"results": [{"label": "a"}, this is not read)", document));
+    EXPECT_EQ(document["results"][0]["label"].asString(), "a");
+}
+
+TEST(JsonExtractor, malformed){
+    JsonExtractor extractor({"results.0"});
+    Json::Value document;
+
+    EXPECT_FALSE(extractor.extract(R"({"results": [{"label": "a")", document));
+    EXPECT_FALSE(extractor.extract(R"({"results" [])", document));
+    EXPECT_FALSE(extractor.extract(R"({"other": 1} trailing)", document));
+    EXPECT_FALSE(extractor.extract("", document));
+}
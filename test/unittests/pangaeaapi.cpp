@@ -0,0 +1,66 @@
+#include "util/pangaeaapi.h"
+#include <gtest/gtest.h>
+
+static const std::string distribution = R"("distribution": {"fileFormat": "text/tab-separated-values", "contentUrl": "https://doi.pangaea.de/10.1594/PANGAEA.0?format=textfile"})";
+
+static PangaeaAPI::MetaData parseMetaData(const std::string &spatialCoverage) {
+    Json::Value json;
+    Json::Reader reader;
+    reader.parse(R"({"name": "test", )" + distribution + R"(, "spatialCoverage": {"@type": "Place", "geo": )" + spatialCoverage + "}}", json);
+    return PangaeaAPI::MetaData(json);
+}
+
+TEST(PangaeaAPI, intersectsSpatialCoverageBox){
+    // the box is given as "south west north east"
+    auto metaData = parseMetaData(R"({"@type": "GeoShape", "box": "-10 20 10 40"})");
+    ASSERT_EQ(metaData.spatialCoverageType, PangaeaAPI::MetaData::SpatialCoverageType::BOX);
+
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(-180, -90, 180, 90));
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(25, -5, 30, 5));
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(0, 0, 25, 50));
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(40, 10, 50, 20));
+
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(0, -10, 19, 10));
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(41, -10, 60, 10));
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(20, 11, 40, 30));
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(20, -30, 40, -11));
+}
+
+TEST(PangaeaAPI, intersectsSpatialCoverageAntimeridian){
+    // west of the antimeridian at 170 to east of it at -170
+    auto metaData = parseMetaData(R"({"@type": "GeoShape", "box": "-10 170 10 -170"})");
+
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(-180, -90, 180, 90));
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(175, -5, 180, 5));
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(-180, -5, -175, 5));
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(160, -5, 170, 5));
+
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(0, -5, 10, 5));
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(-169, -5, 169, 5));
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(175, 20, 180, 30));
+}
+
+TEST(PangaeaAPI, intersectsSpatialCoveragePoint){
+    auto metaData = parseMetaData(R"({"@type": "GeoCoordinates", "latitude": 50.5, "longitude": 8.25})");
+    ASSERT_EQ(metaData.spatialCoverageType, PangaeaAPI::MetaData::SpatialCoverageType::POINT);
+
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(0, 40, 10, 60));
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(8.25, 50.5, 8.25, 50.5));
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(8.25, 50, 9, 50.5));
+
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(8.3, 40, 10, 60));
+    EXPECT_FALSE(metaData.intersectsSpatialCoverage(0, 50.6, 10, 60));
+}
+
+TEST(PangaeaAPI, intersectsSpatialCoverageUnknown){
+    // without bounds nothing can be excluded
+    auto metaData = parseMetaData(R"({"@type": "GeoShape"})");
+    EXPECT_TRUE(metaData.intersectsSpatialCoverage(0, 0, 1, 1));
+
+    Json::Value json;
+    Json::Reader reader;
+    reader.parse("{" + distribution + "}", json);
+    PangaeaAPI::MetaData withoutCoverage(json);
+    EXPECT_EQ(withoutCoverage.spatialCoverageType, PangaeaAPI::MetaData::SpatialCoverageType::NONE);
+    EXPECT_TRUE(withoutCoverage.intersectsSpatialCoverage(0, 0, 1, 1));
+}
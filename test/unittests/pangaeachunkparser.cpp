@@ -0,0 +1,130 @@
+#include "util/pangaeachunkparser.h"
+#include "util/csv_source_util.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
+
+static const std::vector<std::string> columnNames {"Event", "Latitude", "Longitude", "Depth water [m]", "Name"};
+
+static Json::Value createParams() {
+    Json::Value params;
+    params["geometry"] = "xy";
+    params["separator"] = "\t";
+    params["columns"]["x"] = "Longitude";
+    params["columns"]["y"] = "Latitude";
+    params["columns"]["numeric"].append("Depth water [m]");
+    params["columns"]["textual"].append("Name");
+    return params;
+}
+
+static std::string createHeader(const std::vector<std::string> &names) {
+    std::string header;
+    for(size_t i = 0; i < names.size(); i++)
+        header += (i > 0 ? "\t\"" : "\"") + names[i] + "\"";
+    return header + "\n";
+}
+
+/**
+ * rows without header, where some runs of rows have quoted fields with separators and line breaks,
+ * so that some chunks are parsed by the tab parser and others by CSVSourceUtil
+ */
+static std::string createRows() {
+    std::string rows;
+    for(int i = 0; i < 400; i++) {
+        std::string name = "plain " + std::to_string(i);
+        if(i % 60 >= 40 && i % 60 < 45)
+            name = i % 2 == 0 ? "\"quoted\t" + std::to_string(i) + "\"" : "\"line\nbreak \"\"" + std::to_string(i) + "\"\"\"";
+        std::string depth = i % 7 == 0 ? "" : std::to_string(i % 100);
+        rows += "E" + std::to_string(i) + "\t" + std::to_string(i % 170 - 85) + "\t" + std::to_string(i * 7 % 350 - 175) + "\t" + depth + "\t" + name + "\n";
+    }
+    return rows;
+}
+
+static QueryRectangle createRect(double x1, double y1, double x2, double y2) {
+    return QueryRectangle(SpatialReference(CrsId::wgs84(), x1, y1, x2, y2), TemporalReference::unreferenced(), QueryResolution::none());
+}
+
+static std::unique_ptr<PointCollection> parseChunked(const std::string &rows, const QueryRectangle &rect, ThreadPool &pool, bool withTabParser) {
+    Json::Value params = createParams();
+    std::shared_ptr<PangaeaTabParser> tabParser;
+    if(withTabParser)
+        tabParser = std::make_shared<PangaeaTabParser>(columnNames, params);
+
+    std::vector<std::string> projected {"Latitude", "Longitude", "Depth water [m]", "Name"};
+    PangaeaChunkParser parser(tabParser, params, "", std::vector<size_t> {1, 2, 3, 4}, createHeader(projected));
+
+    std::istringstream data(rows);
+    return parser.parse(data, rect, pool, 256, 64);
+}
+
+static std::unique_ptr<PointCollection> parseSequentially(const std::string &rows, const QueryRectangle &rect) {
+    CSVSourceUtil csvUtil(createParams());
+    std::istringstream data(createHeader(columnNames) + rows);
+    return csvUtil.getPointCollection(data, rect);
+}
+
+static void expectEqualPoints(const PointCollection &expected, const PointCollection &actual) {
+    ASSERT_EQ(actual.getFeatureCount(), expected.getFeatureCount());
+    for(size_t i = 0; i < expected.getFeatureCount(); i++) {
+        EXPECT_EQ(actual.coordinates[i].x, expected.coordinates[i].x);
+        EXPECT_EQ(actual.coordinates[i].y, expected.coordinates[i].y);
+
+        double expectedDepth = expected.feature_attributes.numeric("Depth water [m]").get(i);
+        double actualDepth = actual.feature_attributes.numeric("Depth water [m]").get(i);
+        if(std::isnan(expectedDepth))
+            EXPECT_TRUE(std::isnan(actualDepth));
+        else
+            EXPECT_EQ(actualDepth, expectedDepth);
+
+        EXPECT_EQ(actual.feature_attributes.textual("Name").get(i), expected.feature_attributes.textual("Name").get(i));
+    }
+}
+
+TEST(PangaeaChunkParser, mixedQuotedAndUnquotedChunks){
+    ThreadPool pool(3);
+    std::string rows = createRows();
+
+    for(auto &rect : {createRect(-180, -90, 180, 90), createRect(-50, -20, 100, 60)}) {
+        auto expected = parseSequentially(rows, rect);
+        ASSERT_GT(expected->getFeatureCount(), 0);
+
+        auto mixed = parseChunked(rows, rect, pool, true);
+        ASSERT_TRUE(mixed != nullptr);
+        expectEqualPoints(*expected, *mixed);
+
+        auto generic = parseChunked(rows, rect, pool, false);
+        ASSERT_TRUE(generic != nullptr);
+        expectEqualPoints(*expected, *generic);
+    }
+
+    // the quoted fields were kept intact
+    auto points = parseChunked(rows, createRect(-180, -90, 180, 90), pool, true);
+    EXPECT_EQ(points->feature_attributes.textual("Name").get(40), "quoted\t40");
+    EXPECT_EQ(points->feature_attributes.textual("Name").get(41), "line\nbreak \"41\"");
+}
+
+TEST(PangaeaChunkParser, noData){
+    ThreadPool pool(1);
+    EXPECT_TRUE(parseChunked("", createRect(-180, -90, 180, 90), pool, true) == nullptr);
+}
+
+TEST(PangaeaChunkParser, appendRequiresEqualAttributes){
+    auto rect = createRect(-180, -90, 180, 90);
+    std::string row = "E1\t10\t20\t5\ta\n";
+
+    PangaeaTabParser tabParser(columnNames, createParams());
+    auto target = tabParser.createCollection(rect);
+    tabParser.parse(row.data(), row.data() + row.size(), *target);
+
+    auto source = tabParser.createCollection(rect);
+    tabParser.parse(row.data(), row.data() + row.size(), *source);
+    PangaeaChunkParser::appendPoints(*target, *source);
+    EXPECT_EQ(target->getFeatureCount(), 2);
+
+    Json::Value params = createParams();
+    params["columns"]["textual"].append("Event");
+    PangaeaTabParser otherParser(columnNames, params);
+    auto other = otherParser.createCollection(rect);
+    otherParser.parse(row.data(), row.data() + row.size(), *other);
+    EXPECT_THROW(PangaeaChunkParser::appendPoints(*target, *other), MustNotHappenException);
+}
@@ -0,0 +1,199 @@
+#include "util/pangaeacolumnstore.h"
+#include "util/pangaeatabparser.h"
+#include "temporarydirectory.h"
+#include <gtest/gtest.h>
+#include <cmath>
+
+static const std::vector<std::string> columnNames {"Event", "Latitude", "Longitude", "Depth water [m]", "Name"};
+
+static std::vector<PangaeaAPI::Parameter> createParameters(const std::vector<std::string> &names) {
+    std::vector<PangaeaAPI::Parameter> parameters;
+    for(auto &name : names) {
+        Json::Value json;
+        json["name"] = name;
+        if(name != "Event" && name != "Name")
+            json["unitText"] = "m";
+        parameters.emplace_back(json, parameters);
+    }
+    return parameters;
+}
+
+/**
+ * rows without header: points at the corners and edges of the extent, rows with missing values
+ * and enough points spread over the extent for a grid with several cells
+ */
+static std::string createRows() {
+    std::string rows;
+    rows += "E1\t10.5\t20\t5\ta\n";
+    rows += "E2\t-30\t-170\t\tb\n";
+    rows += "E3\t80\t179.5\t7\t\n";
+    rows += "E4\t\t12\t1\twithout latitude\n";
+    rows += "E5\t-90\t-180\t2\tcorner\r\n";
+    rows += "\n";
+    rows += "E6\t90\t180\t3\tedge\n";
+    for(int i = 1; i <= 2000; i++) {
+        rows += "G\t" + std::to_string(i * 37 % 181 - 90) + "\t" + std::to_string(i * 53 % 361 - 180) + "\t" + std::to_string(i) + "\tgrid\n";
+    }
+    rows += "E7\t0\t0\t4\tlast";
+    return rows;
+}
+
+static std::string createHeader(const std::vector<std::string> &names) {
+    std::string header = "/* description */\n";
+    for(size_t i = 0; i < names.size(); i++)
+        header += (i > 0 ? "\t" : "") + names[i];
+    return header + "\n";
+}
+
+static Json::Value createParams(const std::string &x, const std::string &y) {
+    Json::Value params;
+    params["geometry"] = "xy";
+    params["separator"] = "\t";
+    params["columns"]["x"] = x;
+    params["columns"]["y"] = y;
+    params["columns"]["numeric"].append("Depth water [m]");
+    params["columns"]["textual"].append("Name");
+    return params;
+}
+
+static QueryRectangle createRect(double x1, double y1, double x2, double y2) {
+    return QueryRectangle(SpatialReference(CrsId::wgs84(), x1, y1, x2, y2), TemporalReference::unreferenced(), QueryResolution::none());
+}
+
+/**
+ * parse the rows with the text parser
+ */
+static std::unique_ptr<PointCollection> parseRows(const std::string &rows, const Json::Value &params, const QueryRectangle &rect) {
+    PangaeaTabParser parser(columnNames, params);
+    auto points = parser.createCollection(rect);
+    parser.parse(rows.data(), rows.data() + rows.size(), *points);
+    return points->filterBySpatioTemporalReferenceIntersection(rect);
+}
+
+static void expectEqualPoints(const PointCollection &expected, const PointCollection &actual) {
+    ASSERT_EQ(actual.getFeatureCount(), expected.getFeatureCount());
+    for(size_t i = 0; i < expected.getFeatureCount(); i++) {
+        EXPECT_EQ(actual.coordinates[i].x, expected.coordinates[i].x);
+        EXPECT_EQ(actual.coordinates[i].y, expected.coordinates[i].y);
+
+        double expectedDepth = expected.feature_attributes.numeric("Depth water [m]").get(i);
+        double actualDepth = actual.feature_attributes.numeric("Depth water [m]").get(i);
+        if(std::isnan(expectedDepth))
+            EXPECT_TRUE(std::isnan(actualDepth));
+        else
+            EXPECT_EQ(actualDepth, expectedDepth);
+
+        EXPECT_EQ(actual.feature_attributes.textual("Name").get(i), expected.feature_attributes.textual("Name").get(i));
+    }
+}
+
+TEST(PangaeaColumnStore, buildAndOpen){
+    TemporaryDirectory directory;
+    FileCache cache(directory.getPath());
+    std::string rows = createRows();
+    cache.put("doi.tab", createHeader(columnNames) + rows);
+
+    PangaeaColumnStore::build(cache, "doi", createParameters(columnNames));
+    auto store = PangaeaColumnStore::open(cache, "doi");
+    ASSERT_TRUE(store != nullptr);
+
+    Json::Value params = createParams("Longitude", "Latitude");
+    QueryRectangle rect = createRect(-180, -90, 180, 90);
+    auto points = store->getPoints(params, rect);
+    ASSERT_TRUE(points != nullptr);
+
+    // all rows with coordinates, in the order of the data set
+    EXPECT_EQ(points->getFeatureCount(), 2006);
+    expectEqualPoints(*parseRows(rows, params, rect), *points);
+
+    // columns the store does not have are left to the text parser
+    params["columns"]["numeric"].append("Salinity");
+    EXPECT_TRUE(store->getPoints(params, rect) == nullptr);
+
+    PangaeaColumnStore::remove(cache, "doi");
+    EXPECT_TRUE(PangaeaColumnStore::open(cache, "doi") == nullptr);
+}
+
+TEST(PangaeaColumnStore, rectangles){
+    TemporaryDirectory directory;
+    FileCache cache(directory.getPath());
+    std::string rows = createRows();
+    cache.put("doi.tab", createHeader(columnNames) + rows);
+    PangaeaColumnStore::build(cache, "doi", createParameters(columnNames));
+    auto store = PangaeaColumnStore::open(cache, "doi");
+    ASSERT_TRUE(store != nullptr);
+
+    Json::Value lonLat = createParams("Longitude", "Latitude");
+    Json::Value latLon = createParams("Latitude", "Longitude");
+    std::vector<QueryRectangle> rects {
+            createRect(-180, -90, -180, -90), // corner of the extent and the grid
+            createRect(179.5, 80, 180, 90),   // edge of the extent and the last grid cell
+            createRect(20, 10.5, 20, 10.5),   // single point
+            createRect(-10, -10, 10, 10),
+            createRect(-200, -100, 200, 100), // beyond the extent
+            createRect(181, 0, 190, 10),      // outside the extent
+            createRect(-90, -180, 90, 180)    // for lat/lon queries
+    };
+
+    for(auto &rect : rects) {
+        for(auto &params : {lonLat, latLon}) {
+            auto points = store->getPoints(params, rect);
+            ASSERT_TRUE(points != nullptr);
+            expectEqualPoints(*parseRows(rows, params, rect), *points);
+        }
+    }
+
+    EXPECT_EQ(store->getPoints(lonLat, createRect(-180, -90, -180, -90))->getFeatureCount(), 1);
+    EXPECT_EQ(store->getPoints(lonLat, createRect(181, 0, 190, 10))->getFeatureCount(), 0);
+    auto swapped = store->getPoints(latLon, createRect(10.5, 20, 10.5, 20));
+    ASSERT_EQ(swapped->getFeatureCount(), 1);
+    EXPECT_EQ(swapped->coordinates[0].x, 10.5);
+    EXPECT_EQ(swapped->coordinates[0].y, 20);
+}
+
+TEST(PangaeaColumnStore, invalidFiles){
+    TemporaryDirectory directory;
+    FileCache cache(directory.getPath());
+    cache.put("doi.tab", createHeader(columnNames) + createRows());
+    PangaeaColumnStore::build(cache, "doi", createParameters(columnNames));
+
+    std::string content;
+    ASSERT_TRUE(cache.get("doi.cols", content));
+    ASSERT_TRUE(PangaeaColumnStore::open(cache, "doi") != nullptr);
+
+    for(size_t size : {size_t(0), size_t(8), size_t(100), content.size() / 2, content.size() - 1}) {
+        cache.put("doi.cols", content.substr(0, size));
+        EXPECT_TRUE(PangaeaColumnStore::open(cache, "doi") == nullptr) << "truncated to " << size;
+    }
+
+    std::string corrupt = content;
+    corrupt[0] = 'X';
+    cache.put("doi.cols", corrupt);
+    EXPECT_TRUE(PangaeaColumnStore::open(cache, "doi") == nullptr);
+
+    // a row count that does not fit the columns
+    corrupt = content;
+    corrupt[8 + 7] = '\x7f';
+    cache.put("doi.cols", corrupt);
+    EXPECT_TRUE(PangaeaColumnStore::open(cache, "doi") == nullptr);
+}
+
+TEST(PangaeaColumnStore, notBuilt){
+    TemporaryDirectory directory;
+    FileCache cache(directory.getPath());
+
+    // no data file
+    PangaeaColumnStore::build(cache, "doi", createParameters(columnNames));
+    EXPECT_TRUE(PangaeaColumnStore::open(cache, "doi") == nullptr);
+
+    // no longitude/latitude columns
+    std::vector<std::string> names {"Event", "Depth water [m]", "Name"};
+    cache.put("doi.tab", createHeader(names) + "E1\t5\ta\n");
+    PangaeaColumnStore::build(cache, "doi", createParameters(names));
+    EXPECT_TRUE(PangaeaColumnStore::open(cache, "doi") == nullptr);
+
+    // quotes are only handled by the generic CSV parser
+    cache.put("doi.tab", createHeader(columnNames) + "E1\t10\t20\t5\t\"a\tb\"\n");
+    PangaeaColumnStore::build(cache, "doi", createParameters(columnNames));
+    EXPECT_TRUE(PangaeaColumnStore::open(cache, "doi") == nullptr);
+}
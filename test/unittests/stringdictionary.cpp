@@ -0,0 +1,15 @@
+#include "util/stringdictionary.h"
+#include <gtest/gtest.h>
+
+TEST(StringDictionary, encode){
+    StringDictionary dictionary;
+    std::vector<std::string> column {"HUMAN_OBSERVATION", "PRESERVED_SPECIMEN", "HUMAN_OBSERVATION", "", "PRESERVED_SPECIMEN"};
+
+    auto codes = dictionary.encodeAll(column.size(), [&](size_t i) -> const std::string & { return column[i]; });
+
+    EXPECT_EQ(dictionary.size(), 3);
+    EXPECT_EQ(codes, (std::vector<StringDictionary::Code> {0, 1, 0, 2, 1}));
+    EXPECT_EQ(dictionary.getValues(), (std::vector<std::string> {"HUMAN_OBSERVATION", "PRESERVED_SPECIMEN", ""}));
+    EXPECT_EQ(dictionary.decode(codes[3]), "");
+    EXPECT_EQ(dictionary.encode("PRESERVED_SPECIMEN"), 1);
+}
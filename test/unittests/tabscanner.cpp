@@ -0,0 +1,154 @@
+
+#include "util/tabscanner.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+static void expectSameAsStrtod(const char *field) {
+    double value = 0;
+    char *end;
+    double expected = std::strtod(field, &end);
+
+    EXPECT_EQ(TabScanner::parseDouble(field, field + std::strlen(field), value), end != field) << field;
+    if(end != field) {
+        EXPECT_EQ(std::memcmp(&value, &expected, sizeof(double)), 0) << field;
+    }
+}
+
+TEST(TabScanner, findDelimiter){
+    std::string line = "LATITUDE\tLONGITUDE with a rather long description\tIce extent\nnext line";
+    const char *begin = line.data();
+    const char *end = line.data() + line.size();
+
+    const char *first = TabScanner::findDelimiter(begin, end, '\t');
+    EXPECT_EQ(first - begin, 8);
+
+    const char *second = TabScanner::findDelimiter(first + 1, end, '\t');
+    EXPECT_EQ(std::string(first + 1, second), "LONGITUDE with a rather long description");
+
+    const char *third = TabScanner::findDelimiter(second + 1, end, '\t');
+    EXPECT_EQ(*third, '\n');
+
+    EXPECT_EQ(TabScanner::findDelimiter(third + 1, end, '\t'), end);
+}
+
+TEST(TabScanner, projectFields){
+    std::string data = "a\tb\tc\td\r\n\n1\t2\n1\t2\t3\t4";
+    std::vector<size_t> indices = {1, 3};
+
+    std::string out;
+    TabScanner::projectFields(data.data(), data.data() + data.size(), '\t', indices, out);
+
+    EXPECT_EQ(out, "b\td\n\n2\n2\t4\n");
+}
+
+/**
+ * sequential reference parser with the quoting rules of CSVSourceUtil
+ */
+static std::vector<std::vector<std::string>> parseRecords(const std::string &data, char separator) {
+    std::vector<std::vector<std::string>> records;
+    std::vector<std::string> record;
+    std::string field;
+    bool insideQuotes = false;
+    bool fieldStart = true;
+    for(size_t i = 0; i < data.size(); ++i) {
+        char c = data[i];
+        if(insideQuotes) {
+            if(c == '"' && i + 1 < data.size() && data[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if(c == '"') {
+                insideQuotes = false;
+            } else {
+                field += c;
+            }
+        } else if(c == '"' && fieldStart) {
+            insideQuotes = true;
+            fieldStart = false;
+        } else if(c == separator || c == '\n') {
+            record.push_back(field);
+            field.clear();
+            fieldStart = true;
+            if(c == '\n') {
+                records.push_back(record);
+                record.clear();
+            }
+        } else {
+            field += c;
+            fieldStart = false;
+        }
+    }
+    return records;
+}
+
+TEST(TabScanner, readChunkKeepsRecords){
+    std::string data = "1\t\"quoted\ttext\"\t3\n"
+                       "2\t\"multi\nline \"\"quoted\"\"\n\"\t4\n"
+                       "3\t12\" 30'\tunquoted quote\n"
+                       "4\t\"\"\t\"a\"\"\n\"\"b\"\n"
+                       "5\tlast\tline\n";
+
+    auto sequential = parseRecords(data, '\t');
+    ASSERT_EQ(sequential.size(), 5);
+
+    for(size_t size = 0; size <= data.size(); ++size) {
+        std::istringstream in(data);
+        std::string chunk;
+        std::string concatenated;
+        std::vector<std::vector<std::string>> chunked;
+        while(TabScanner::readChunk(in, size, '\t', chunk)) {
+            EXPECT_FALSE(TabScanner::endsInsideQuotes(chunk.data(), chunk.data() + chunk.size(), '\t', false)) << size;
+            concatenated += chunk;
+            auto records = parseRecords(chunk, '\t');
+            chunked.insert(chunked.end(), records.begin(), records.end());
+        }
+
+        EXPECT_EQ(concatenated, data) << size;
+        EXPECT_EQ(chunked, sequential) << size;
+    }
+}
+
+TEST(TabScanner, projectQuotedFields){
+    std::string data = "\"a\tb\"\tx\t\"c\nd\"\r\n"
+                       "\"say \"\"hi\"\"\"\ty\t\"\"\"\tlast\"\n"
+                       "12\" 30'\tz\t3\n";
+    std::vector<size_t> indices = {0, 2};
+
+    std::string out;
+    TabScanner::projectFields(data.data(), data.data() + data.size(), '\t', indices, out);
+
+    EXPECT_EQ(out, "\"a\tb\"\t\"c\nd\"\n"
+                   "\"say \"\"hi\"\"\"\t\"\"\"\tlast\"\n"
+                   "12\" 30'\t3\n");
+    std::vector<std::vector<std::string>> expected = {{"a\tb", "c\nd"}, {"say \"hi\"", "\"\tlast"}, {"12\" 30'", "3"}};
+    EXPECT_EQ(parseRecords(out, '\t'), expected);
+
+    // quoted line breaks in unselected fields do not end the record
+    out.clear();
+    indices = {1};
+    TabScanner::projectFields(data.data(), data.data() + data.size(), '\t', indices, out);
+    EXPECT_EQ(out, "x\ny\nz\n");
+}
+
+TEST(TabScanner, parseDoubleSpecialCases){
+    const char *fields[] = {"", "abc", "-", "nan", "inf", "-0", "1e", "1e5x", " 12.5", "0x10",
+                            "00012.50", ".5", "5.", "1.0e-300", "1.7976931348623157e308",
+                            "9007199254740993", "123456789012345678901234567890"};
+    for(const char *field : fields) {
+        expectSameAsStrtod(field);
+    }
+}
+
+TEST(TabScanner, parseDoubleRandom){
+    std::mt19937_64 random(42);
+    const char *formats[] = {"%.17g", "%.6f", "%.3f", "%g", "%.2e", "%.12f"};
+    char field[64];
+
+    for(int i = 0; i < 100000; ++i) {
+        double value = static_cast<double>(static_cast<int64_t>(random() % 20000000) - 10000000) / static_cast<double>(1 + random() % 100000);
+        std::snprintf(field, sizeof(field), formats[i % 6], value);
+        expectSameAsStrtod(field);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef TEST_UNITTESTS_TEMPORARYDIRECTORY_H_
+#define TEST_UNITTESTS_TEMPORARYDIRECTORY_H_
+
+#include <cstdio>
+#include <cstdlib>
+#include <ftw.h>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Directory below /tmp for the files of a test, removed with its contents at the end of the test.
+ */
+class TemporaryDirectory {
+public:
+    TemporaryDirectory() {
+        char pattern[] = "/tmp/mapping_gfbio_test_XXXXXX";
+        if(mkdtemp(pattern) == nullptr)
+            throw std::runtime_error("TemporaryDirectory: could not create a directory");
+        path = pattern;
+    }
+
+    ~TemporaryDirectory() {
+        nftw(path.c_str(), [](const char *file, const struct stat *, int, struct FTW *) {
+            return std::remove(file);
+        }, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    TemporaryDirectory(const TemporaryDirectory&) = delete;
+    TemporaryDirectory &operator=(const TemporaryDirectory&) = delete;
+
+    const std::string &getPath() const {
+        return path;
+    }
+
+private:
+    std::string path;
+};
+
+#endif /* TEST_UNITTESTS_TEMPORARYDIRECTORY_H_ */
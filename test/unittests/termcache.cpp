@@ -0,0 +1,121 @@
+
+#include "util/termcache.h"
+#include "temporarydirectory.h"
+#include <gtest/gtest.h>
+#include <dirent.h>
+#include <string>
+
+static size_t countFiles(const std::string &directory) {
+    size_t files = 0;
+    DIR *dir = opendir(directory.c_str());
+    while(struct dirent *file = readdir(dir)) {
+        if(file->d_name[0] != '.')
+            files++;
+    }
+    closedir(dir);
+    return files;
+}
+
+TEST(TermCache, memory){
+    TermCache cache(1600, nullptr, 3600, 3600);
+    TermCache::Key plum {"NCBITAXON", "plum", "label", "exact", true};
+    TermCache::Key dose {"NCBITAXON", "dose", "label", "exact", true};
+
+    bool resolved;
+    std::string value;
+    EXPECT_FALSE(cache.get(plum, resolved, value));
+
+    cache.put(plum, true, "Prunus domestica");
+    cache.put(dose, false, "");
+
+    EXPECT_TRUE(cache.get(plum, resolved, value));
+    EXPECT_TRUE(resolved);
+    EXPECT_EQ(value, "Prunus domestica");
+
+    EXPECT_TRUE(cache.get(dose, resolved, value));
+    EXPECT_FALSE(resolved);
+
+    // the key includes all search parameters
+    TermCache::Key other = plum;
+    other.firstHit = false;
+    EXPECT_FALSE(cache.get(other, resolved, value));
+
+    TermCache::Statistics statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.memoryHits, 2);
+    EXPECT_EQ(statistics.sharedHits, 0);
+    EXPECT_EQ(statistics.misses, 2);
+}
+
+TEST(TermCache, evictsLeastRecentlyUsed){
+    // one entry per shard
+    TermCache cache(16, nullptr, 3600, 3600);
+
+    for(int i = 0; i < 1000; i++) {
+        cache.put(TermCache::Key {"PESI", std::to_string(i), "label", "exact", true}, true, std::to_string(i));
+    }
+
+    int cached = 0;
+    for(int i = 0; i < 1000; i++) {
+        bool resolved;
+        std::string value;
+        if(cache.get(TermCache::Key {"PESI", std::to_string(i), "label", "exact", true}, resolved, value)) {
+            EXPECT_EQ(value, std::to_string(i));
+            cached++;
+        }
+    }
+    EXPECT_LE(cached, 16);
+}
+
+TEST(TermCache, expiresEntries){
+    TermCache cache(1600, nullptr, 3600, 0);
+    TermCache::Key dose {"NCBITAXON", "dose", "label", "exact", true};
+    cache.put(dose, false, "");
+
+    bool resolved;
+    std::string value;
+    EXPECT_FALSE(cache.get(dose, resolved, value));
+}
+
+TEST(TermCache, shared){
+    TemporaryDirectory temporaryDirectory;
+    const std::string &directory = temporaryDirectory.getPath();
+    TermCache::Key bee {"PESI", "honey bee", "label", "exact", true};
+    TermCache::Key bee_underscore {"PESI", "honey_bee", "label", "exact", true};
+
+    {
+        TermCache cache(1600, std::make_shared<SharedCache>(directory, 0), 3600, 3600);
+        cache.put(bee, true, "Apis mellifera\nLinnaeus, 1758");
+    }
+
+    // a new cache, e.g. of another process, reads the entry from disk
+    TermCache cache(1600, std::make_shared<SharedCache>(directory, 0), 3600, 3600);
+    bool resolved;
+    std::string value;
+    EXPECT_FALSE(cache.get(bee_underscore, resolved, value));
+    EXPECT_TRUE(cache.get(bee, resolved, value));
+    EXPECT_TRUE(resolved);
+    EXPECT_EQ(value, "Apis mellifera\nLinnaeus, 1758");
+
+    EXPECT_TRUE(cache.get(bee, resolved, value));
+    TermCache::Statistics statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.sharedHits, 1);
+    EXPECT_EQ(statistics.memoryHits, 1);
+}
+
+TEST(TermCache, removesExpiredSharedEntries){
+    TemporaryDirectory temporaryDirectory;
+    const std::string &directory = temporaryDirectory.getPath();
+    TermCache::Key dose {"NCBITAXON", "dose", "label", "exact", true};
+
+    {
+        TermCache cache(1600, std::make_shared<SharedCache>(directory, 0), 3600, 0);
+        cache.put(dose, false, "");
+    }
+    EXPECT_EQ(countFiles(directory), 1);
+
+    TermCache cache(1600, std::make_shared<SharedCache>(directory, 0), 3600, 0);
+    bool resolved;
+    std::string value;
+    EXPECT_FALSE(cache.get(dose, resolved, value));
+    EXPECT_EQ(countFiles(directory), 0);
+}
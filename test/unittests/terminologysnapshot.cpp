@@ -0,0 +1,104 @@
+
+#include "util/terminologysnapshot.h"
+#include "temporarydirectory.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+
+static std::unique_ptr<TerminologySnapshot> createSnapshot(const TemporaryDirectory &directory) {
+    const std::string &path = directory.getPath();
+
+    std::ofstream dump(path + "/TEST.jsonl");
+    dump << R"({"label": "Prunus domestica", "uri": "http://example.org/1", "commonNames": ["plum", "European plum"]})" << "\n";
+    dump << "\n";
+    dump << R"({"label": "Apis mellifera", "uri": "http://example.org/2", "commonNames": ["honey bee"], "synonyms": ["Apis mellifica"]})" << "\n";
+    dump << R"({"label": "Plumbago", "uri": "http://example.org/3", "commonNames": ["leadwort"]})" << "\n";
+    dump.close();
+
+    TerminologySnapshot::import(path + "/TEST.jsonl", path + "/TEST.snapshot");
+    return TerminologySnapshot::open(path + "/TEST.snapshot");
+}
+
+TEST(TerminologySnapshot, exact){
+    TemporaryDirectory directory;
+    auto snapshot = createSnapshot(directory);
+    ASSERT_TRUE(snapshot != nullptr);
+
+    Json::Value term;
+    EXPECT_TRUE(snapshot->search("Honey Bee", "exact", term));
+    EXPECT_EQ(term["label"].asString(), "Apis mellifera");
+    EXPECT_TRUE(snapshot->search("apis mellifica", "exact", term));
+    EXPECT_EQ(term["uri"].asString(), "http://example.org/2");
+    EXPECT_FALSE(snapshot->search("honey", "exact", term));
+}
+
+TEST(TerminologySnapshot, included){
+    TemporaryDirectory directory;
+    auto snapshot = createSnapshot(directory);
+    ASSERT_TRUE(snapshot != nullptr);
+
+    Json::Value term;
+    // the first term of the dump wins
+    EXPECT_TRUE(snapshot->search("PLUM", "included", term));
+    EXPECT_EQ(term["label"].asString(), "Prunus domestica");
+    EXPECT_TRUE(snapshot->search("bago", "included", term));
+    EXPECT_EQ(term["label"].asString(), "Plumbago");
+    EXPECT_TRUE(snapshot->search("ey", "included", term));
+    EXPECT_EQ(term["label"].asString(), "Apis mellifera");
+    EXPECT_FALSE(snapshot->search("wasp", "included", term));
+}
+
+TEST(TerminologySnapshot, regex){
+    TemporaryDirectory directory;
+    auto snapshot = createSnapshot(directory);
+    ASSERT_TRUE(snapshot != nullptr);
+
+    Json::Value term;
+    EXPECT_TRUE(snapshot->search("^lead.*t$", "regex", term));
+    EXPECT_EQ(term["label"].asString(), "Plumbago");
+    EXPECT_FALSE(snapshot->search("^bee", "regex", term));
+
+    // literals that are optional or in groups do not limit the candidates
+    EXPECT_TRUE(snapshot->search("honex?y", "regex", term));
+    EXPECT_EQ(term["label"].asString(), "Apis mellifera");
+    EXPECT_TRUE(snapshot->search("(wasp)?wort", "regex", term));
+    EXPECT_EQ(term["label"].asString(), "Plumbago");
+    EXPECT_TRUE(snapshot->search("wasp|Mellif", "regex", term));
+    EXPECT_EQ(term["label"].asString(), "Apis mellifera");
+    EXPECT_TRUE(snapshot->search("europea[nm] plum", "regex", term));
+    EXPECT_EQ(term["label"].asString(), "Prunus domestica");
+    EXPECT_FALSE(snapshot->search("honey\\.bee", "regex", term));
+
+    // the bounds of a quantifier are not part of a literal
+    EXPECT_TRUE(snapshot->search("hon{1,2}ey bee", "regex", term));
+    EXPECT_EQ(term["label"].asString(), "Apis mellifera");
+    EXPECT_TRUE(snapshot->search("lea{1}dwort", "regex", term));
+    EXPECT_EQ(term["label"].asString(), "Plumbago");
+}
+
+TEST(TerminologySnapshot, get){
+    TemporaryDirectory directory;
+    const std::string &path = directory.getPath();
+
+    EXPECT_TRUE(TerminologySnapshot::get(path, "TEST") == nullptr);
+
+    std::ofstream dump(path + "/TEST.jsonl");
+    dump << R"({"label": "Apis mellifera", "uri": "http://example.org/2"})" << "\n";
+    dump.close();
+    // the dump is not imported on demand
+    EXPECT_TRUE(TerminologySnapshot::get(path, "TEST") == nullptr);
+
+    TerminologySnapshot::import(path + "/TEST.jsonl", path + "/TEST.snapshot");
+    auto snapshot = TerminologySnapshot::get(path, "TEST");
+    ASSERT_TRUE(snapshot != nullptr);
+    EXPECT_EQ(TerminologySnapshot::get(path, "TEST"), snapshot);
+
+    // a new import replaces the opened snapshot
+    TerminologySnapshot::import(path + "/TEST.jsonl", path + "/TEST.snapshot");
+    auto replaced = TerminologySnapshot::get(path, "TEST");
+    ASSERT_TRUE(replaced != nullptr);
+    EXPECT_NE(replaced, snapshot);
+
+    Json::Value term;
+    EXPECT_TRUE(replaced->search("apis mellifera", "exact", term));
+}